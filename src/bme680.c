@@ -1,13 +1,237 @@
 #include "bme680.h"
 #include <string.h>
+#include <stddef.h>
 #include "bme68x_defs.h" // <-- VIKTIG: Lades till för att få I2C-adress-definitioner
+#include "i2c_dma.h"
+#include "flash_store.h"
 
-static struct bme68x_dev gas_sensor;
-static i2c_inst_t *bme680_i2c;
+// Standardkonfiguration: samma värden som tidigare sattes vid varje läsning
+static const struct bme68x_conf default_conf = {
+    .os_hum = BME68X_OS_16X,
+    .os_temp = BME68X_OS_2X,
+    .os_pres = BME68X_OS_1X,
+    .filter = BME68X_FILTER_OFF,
+    .odr = BME68X_ODR_NONE,
+};
 
-// Vi antar standard I2C-adress 0x76. 
-// Ändra till BME68X_I2C_ADDR_HIGH (0x77) om du använder den.
-static uint8_t bme_dev_addr = BME68X_I2C_ADDR_LOW;
+static const struct bme68x_heatr_conf default_heatr_conf = {
+    .enable = BME68X_ENABLE,   // Slå PÅ värmaren
+    .heatr_temp = 320,         // Värm till 320 grader
+    .heatr_dur = 150,          // Håll i 150 ms
+};
+
+// Mätsessionen (sensor->session): konfigurationen skrivs till sensorn en gång och
+// mät-/värmetiderna cachas tills konfigurationen faktiskt ändras.
+
+static bool heatr_conf_equal(const struct bme68x_heatr_conf *a, const struct bme68x_heatr_conf *b) {
+    return a->enable == b->enable &&
+           a->heatr_temp == b->heatr_temp &&
+           a->heatr_dur == b->heatr_dur;
+}
+
+// Skriv sessionens konfiguration till sensorn och räkna om väntetiderna
+static bool session_apply(bme680_t *sensor) {
+    bme680_session_t *s = &sensor->session;
+    s->applied = false;
+
+    if (bme68x_set_conf(&s->conf, &sensor->dev) != BME68X_OK) return false;
+    if (bme68x_set_heatr_conf(BME68X_FORCED_MODE, &s->heatr_conf, &sensor->dev) != BME68X_OK) return false;
+
+    // Beräkna väntetid (Mätning + Värmare) en gång per konfiguration
+    s->meas_dur_us = bme68x_get_meas_dur(BME68X_FORCED_MODE, &s->conf, &sensor->dev);
+    s->heat_dur_us = (s->heatr_conf.enable == BME68X_ENABLE) ? (uint32_t)s->heatr_conf.heatr_dur * 1000 : 0; // ms till us
+
+    // Ny mättid: börja om inlärningen från värsta fallet. Skrivs samma
+    // konfiguration tillbaka (t.ex. efter en profilskanning) behålls den.
+    if (s->timing.worst_us != s->meas_dur_us + s->heat_dur_us) {
+        memset(&s->timing, 0, sizeof(s->timing));
+        s->timing.worst_us = s->meas_dur_us + s->heat_dur_us;
+        s->timing.expect_us = s->timing.worst_us;
+    }
+    if (s->tph_timing.worst_us != s->meas_dur_us) {
+        memset(&s->tph_timing, 0, sizeof(s->tph_timing));
+        s->tph_timing.worst_us = s->meas_dur_us;
+        s->tph_timing.expect_us = s->tph_timing.worst_us;
+    }
+
+    s->heater_on = s->heatr_conf.enable == BME68X_ENABLE;
+    s->applied = true;
+    return true;
+}
+
+// Bygg med BME680_TRACE=1 för att skriva ut rådata i samma format som
+// tools/compensation_bench läser ("calib"/"variant"/"field"-rader)
+#ifndef BME680_TRACE
+#define BME680_TRACE 0
+#endif
+
+static void trace_hex(const char *tag, const uint8_t *buf, size_t len) {
+    printf("%s ", tag);
+    for (size_t i = 0; i < len; i++) printf("%02x", buf[i]);
+    printf("\n");
+}
+
+static void trace_calib(const bme680_t *sensor, const uint8_t *coeff) {
+    trace_hex("calib", coeff, BME68X_LEN_COEFF_ALL);
+    printf("variant %u\n", (unsigned)sensor->dev.variant_id);
+}
+
+// Kalibreringen sparas i flash så att en omstart (t.ex. efter dormant/watchdog)
+// slipper läsa de tre kalibreringsbankerna över I2C. En post per buss/adress.
+#define CALIB_MAGIC 0x43383642u // "B68C"
+#define CALIB_VERSION 1
+#define CALIB_SLOTS 4
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t chip_id;
+    uint8_t variant_id;
+    uint8_t bus_addr;       // I2C-block i bit 7, adress i bit 0-6
+    uint8_t coeff[BME68X_LEN_COEFF_ALL];
+    uint8_t pad[2];
+    uint32_t crc;           // CRC-32 över allt ovanför
+} calib_record_t;
+
+static uint8_t calib_bus_addr(const bme680_t *sensor) {
+    return (uint8_t)((i2c_hw_index(sensor->i2c) << 7) | sensor->addr);
+}
+
+static bool calib_record_valid(const calib_record_t *rec) {
+    return rec->magic == CALIB_MAGIC && rec->version == CALIB_VERSION &&
+           rec->crc == flash_store_crc32(rec, offsetof(calib_record_t, crc));
+}
+
+// Leta upp sparad kalibrering för den här sensorn. Returnerar NULL om den saknas eller är trasig.
+static const calib_record_t *calib_load(const bme680_t *sensor) {
+    const calib_record_t *slots = (const calib_record_t *)flash_store_data(FLASH_STORE_SECTOR_CALIB);
+
+    for (int i = 0; i < CALIB_SLOTS; i++) {
+        const calib_record_t *rec = &slots[i];
+        if (calib_record_valid(rec) && rec->bus_addr == calib_bus_addr(sensor) &&
+            rec->chip_id == sensor->dev.chip_id && rec->variant_id == sensor->dev.variant_id) {
+            return rec;
+        }
+    }
+    return NULL;
+}
+
+// Spara kalibreringen i första lediga (eller egna) plats. Övriga sensorers poster behålls.
+static void calib_save(const bme680_t *sensor, const uint8_t *coeff) {
+    calib_record_t slots[CALIB_SLOTS];
+    int free_slot = -1;
+
+    memcpy(slots, flash_store_data(FLASH_STORE_SECTOR_CALIB), sizeof(slots));
+    for (int i = 0; i < CALIB_SLOTS; i++) {
+        if (!calib_record_valid(&slots[i])) {
+            if (free_slot < 0) free_slot = i;
+            memset(&slots[i], 0xFF, sizeof(slots[i]));
+        } else if (slots[i].bus_addr == calib_bus_addr(sensor)) {
+            free_slot = i; // Ersätt sensorns gamla post (t.ex. utbytt sensor)
+            break;
+        }
+    }
+    if (free_slot < 0) free_slot = 0;
+
+    calib_record_t *rec = &slots[free_slot];
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = CALIB_MAGIC;
+    rec->version = CALIB_VERSION;
+    rec->chip_id = sensor->dev.chip_id;
+    rec->variant_id = sensor->dev.variant_id;
+    rec->bus_addr = calib_bus_addr(sensor);
+    memcpy(rec->coeff, coeff, BME68X_LEN_COEFF_ALL);
+    rec->crc = flash_store_crc32(rec, offsetof(calib_record_t, crc));
+
+    if (!flash_store_write(FLASH_STORE_SECTOR_CALIB, slots, sizeof(slots))) {
+        printf("BME680: kunde inte spara kalibrering i flash\n");
+    }
+}
+
+// Stämmer posten med sensorn? chip_id är 0x61 på alla BME68x, så en utbytt
+// sensor på samma adress känns bara igen på koefficienterna. Läs den mellersta
+// banken (14 bytes, bl.a. par_t1 och par_h*) och jämför med posten.
+static bool calib_matches(bme680_t *sensor, const calib_record_t *rec) {
+    uint8_t bank[BME68X_LEN_COEFF2];
+
+    if (bme68x_get_regs(BME68X_REG_COEFF2, bank, sizeof(bank), &sensor->dev) != BME68X_OK) {
+        return false;
+    }
+    return memcmp(bank, &rec->coeff[BME68X_LEN_COEFF1], sizeof(bank)) == 0;
+}
+
+// Ladda kalibreringen från flash, eller läs den från sensorn och spara den
+static bool calib_init(bme680_t *sensor) {
+    const calib_record_t *rec = calib_load(sensor);
+    uint8_t coeff[BME68X_LEN_COEFF_ALL];
+
+    if (rec && calib_matches(sensor, rec)) {
+        memcpy(coeff, rec->coeff, sizeof(coeff));
+    } else {
+        if (bme68x_get_calib_raw(coeff, &sensor->dev) != BME68X_OK) return false;
+        calib_save(sensor, coeff);
+    }
+
+    if (BME680_TRACE) trace_calib(sensor, coeff);
+    return bme68x_set_calib_raw(coeff, &sensor->dev) == BME68X_OK;
+}
+
+// Asynkron mätning: forced mode triggas direkt och ett timeralarm armeras till
+// den inlärda mättiden (session.timing.expect_us). Alarmet startar DMA-läsningen
+// av fältregistren, så inget väntar i sleep_us() medan värmaren är på.
+// Kommer läsningen för tidigt pollas bara statusbyten (new_data i FIELD0) tills
+// mätningen är klar. bme680_async_task() tolkar resultatet och anropar cb.
+// Tillståndet ligger i sensor->async.
+
+// Ge upp om sensorn inte är klar så här långt efter värsta fallet
+#define ASYNC_OVERRUN_US (5 * BME68X_PERIOD_POLL)
+
+// Väntetid innan alarmet försöker igen när bussen är upptagen av en annan sensor
+#define ASYNC_BUS_RETRY_US 200
+
+// Inlärning av mättiden
+#define ADAPT_POLL_US 500       // Statuspollning efter en för tidig läsning
+#define ADAPT_MARGIN_US 1000    // Marginal över observerad klartid
+#define ADAPT_STEP_US 250       // Krympning efter ADAPT_SHRINK_HITS träffar i rad
+#define ADAPT_SHRINK_HITS 16
+
+typedef enum {
+    ASYNC_IDLE,
+    ASYNC_MEASURING,    // Sensorn mäter, alarmet är armerat
+    ASYNC_POLLING,      // DMA-läsning av statusbyten pågår
+    ASYNC_READING,      // DMA-läsning av fältregistren pågår
+    ASYNC_DONE,         // Fältdatat ligger i async.field, väntar på bme680_async_task()
+} async_state_t;
+
+typedef enum {
+    ASYNC_MODE_READ,            // Vanlig forced-mätning
+    ASYNC_MODE_SCAN_FORCED,     // Profilskanning, ett forced-steg i taget (BME680)
+    ASYNC_MODE_SCAN_PARALLEL,   // Profilskanning i parallellt läge (BME688)
+    ASYNC_MODE_LATEST,          // Kontinuerligt läge: läs senaste fältet (BME688)
+} async_mode_t;
+
+// Kontinuerligt läge: ge upp om sensorn inte levererat något på så här länge
+#define ASYNC_LATEST_LIMIT_US 2000000
+
+static void data_to_reading(const struct bme68x_data *data, bme680_reading_t *r) {
+#ifdef BME68X_USE_FPU
+    // Flyttalsbygget: avrunda till samma fixpunktsenheter som heltalsbygget
+    r->temperature = (int32_t)(data->temperature * 100.0f + (data->temperature < 0 ? -0.5f : 0.5f));
+    r->humidity = (uint32_t)(data->humidity * 1000.0f + 0.5f);
+    r->pressure = (uint32_t)(data->pressure + 0.5f);
+    r->gas = (uint32_t)(data->gas_resistance + 0.5f);
+#else
+    // Drivrutinen räknar redan i °C x100, % x1000, Pa och ohm
+    r->temperature = data->temperature;
+    r->humidity = data->humidity;
+    r->pressure = data->pressure;
+    r->gas = data->gas_resistance;
+#endif
+    // Ogiltig gasmätning (t.ex. för kort väntetid eller värmaren av) rapporteras som 0
+    r->has_gas = (data->status & BME68X_GASM_VALID_MSK) != 0;
+    if (!r->has_gas) r->gas = 0;
+    r->heat_stab = (data->status & BME68X_HEAT_STAB_MSK) != 0;
+}
 
 // Callbackfunktion för delay (Pico SDK)
 static void bme68x_delay_us(uint32_t period, void *intf_ptr) {
@@ -16,120 +240,679 @@ static void bme68x_delay_us(uint32_t period, void *intf_ptr) {
 
 // I2C read enligt NYA BME68x API
 // (Signaturen är ändrad: 'dev_id' är borta)
+// Registeradress + data går i en DMA-transaktion, CPU:n sover under tiden
 static int8_t i2c_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void *intf_ptr) {
-    // Hämta I2C-adressen från intf_ptr
-    uint8_t dev_id = *(uint8_t*)intf_ptr;
-    // Hämta I2C-bussen från den globala variabeln
-    i2c_inst_t *i2c = bme680_i2c;
+    // intf_ptr pekar på sensorn, som vet sin buss och adress
+    const bme680_t *sensor = intf_ptr;
 
-    if (i2c_write_blocking(i2c, dev_id, &reg_addr, 1, true) != 1) return -1; // true = skicka STOP efteråt
-    if (i2c_read_blocking(i2c, dev_id, data, (long unsigned int)len, false) != (int)len) return -1; // false = skicka STOP
-    return 0;
+    return i2c_dma_read_reg(sensor->i2c, sensor->addr, reg_addr, data, len) ? 0 : -1;
 }
 
 // I2C write enligt NYA BME68x API
 // (Signaturen är ändrad: 'dev_id' är borta)
 static int8_t i2c_write(uint8_t reg_addr, const uint8_t *data, uint32_t len, void *intf_ptr) {
-    // Hämta I2C-adressen från intf_ptr
-    uint8_t dev_id = *(uint8_t*)intf_ptr;
-    // Hämta I2C-bussen från den globala variabeln
-    i2c_inst_t *i2c = bme680_i2c;
-    
-    uint8_t buf[len + 1];
-    buf[0] = reg_addr;
-    memcpy(buf + 1, data, len); // Effektivare än en for-loop
-
-    if (i2c_write_blocking(i2c, dev_id, buf, len + 1, false) != (int)(len + 1)) return -1; // false = skicka STOP
-    return 0;
+    const bme680_t *sensor = intf_ptr;
+
+    return i2c_dma_write_reg(sensor->i2c, sensor->addr, reg_addr, data, len) ? 0 : -1;
+}
+
+// Init en I2C-buss med DMA (400 kHz fast mode som standard, se BME680_I2C_BAUDRATE)
+bool bme680_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin) {
+    return i2c_dma_init(i2c, sda_pin, scl_pin, BME680_I2C_BAUDRATE);
 }
 
 // Init BME680
-bool bme680_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin) {
-    bme680_i2c = i2c; // Spara I2C-bussen globalt för read/write
-
-    // Init I2C
-    i2c_init(i2c, 100000);
-    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
-    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
-    gpio_pull_up(sda_pin);
-    gpio_pull_up(scl_pin);
-
-    memset(&gas_sensor, 0, sizeof(gas_sensor));
-    gas_sensor.intf = BME68X_I2C_INTF;
-    
-    // ** FIX 1: Peka intf_ptr till vår I2C-adress-variabel **
-    gas_sensor.intf_ptr = &bme_dev_addr; 
-    
-    gas_sensor.read = i2c_read;
-    gas_sensor.write = i2c_write;
-    gas_sensor.delay_us = bme68x_delay_us;
-    
-    // ** FIX 2: Denna rad är borttagen, den finns inte i nya API:et **
-    // gas_sensor.variant = BME68X_VARIANT_680;
-
-    // API:et kommer nu anropa bme68x_init(), som anropar vår i2c_read()
-    // som nu korrekt hämtar adressen (0x76) från intf_ptr.
-    if (bme68x_init(&gas_sensor) != BME68X_OK) return false;
+bool bme680_init(bme680_t *sensor, i2c_inst_t *i2c, uint8_t addr) {
+    memset(sensor, 0, sizeof(*sensor));
+    sensor->i2c = i2c;
+    sensor->addr = addr;
+    sensor->async.state = ASYNC_IDLE;
+
+    struct bme68x_dev *dev = &sensor->dev;
+    dev->intf = BME68X_I2C_INTF;
+
+    // intf_ptr pekar på sensorn så att i2c_read/i2c_write hittar rätt buss och adress
+    dev->intf_ptr = sensor;
 
+    dev->read = i2c_read;
+    dev->write = i2c_write;
+    dev->delay_us = bme68x_delay_us;
+
+    // Vi publicerar inte res_heat/idac/gas_wait, så de behöver inte läsas med varje mätning
+    dev->skip_heatr_meta = BME68X_ENABLE;
+
+    // Samma som bme68x_init(), men kalibreringen hämtas från flash när den finns där
+    if (bme68x_probe(dev) != BME68X_OK) return false;
+    if (!calib_init(sensor)) return false;
+
+    // Skriv standardkonfigurationen en gång, bme680_read() återanvänder den
+    return bme680_configure(sensor, &default_conf, &default_heatr_conf);
+}
+
+// Byt konfiguration. Sensorn konfigureras bara om om något faktiskt ändrats.
+bool bme680_configure(bme680_t *sensor, const struct bme68x_conf *conf, const struct bme68x_heatr_conf *heatr_conf) {
+    bme680_session_t *s = &sensor->session;
+    if (!conf || !heatr_conf) return false;
+
+    if (s->applied &&
+        memcmp(&s->conf, conf, sizeof(*conf)) == 0 &&
+        heatr_conf_equal(&s->heatr_conf, heatr_conf)) {
+        return true; // Oförändrat, ingen I2C-trafik
+    }
+
+    // set_conf lägger sensorn i sleep, så ett kontinuerligt läge avslutas först
+    if (sensor->continuous && !bme680_continuous_stop(sensor)) return false;
+
+    s->conf = *conf;
+    s->heatr_conf = *heatr_conf;
+    return session_apply(sensor);
+}
+
+const bme680_session_t *bme680_get_session(const bme680_t *sensor) {
+    return &sensor->session;
+}
+
+// Antal I2C-transaktioner som registerskuggan i drivrutinen har sparat in
+uint32_t bme680_saved_transfers(const bme680_t *sensor) {
+    return sensor->dev.shadow.saved_xfers;
+}
+
+// Körs i I2C-avbrottet när DMA-läsningen av fältregistren är klar
+static void field_read_done(bool ok, void *user_data) {
+    bme680_t *sensor = user_data;
+
+    sensor->async.done_us = time_us_32();
+    sensor->async.xfer_ok = ok;
+    sensor->async.state = ASYNC_DONE;
+}
+
+static uint32_t async_elapsed_us(const bme680_t *sensor) {
+    return time_us_32() - sensor->async.trigger_us;
+}
+
+static bool async_overdue(const bme680_t *sensor) {
+    return async_elapsed_us(sensor) > sensor->async.limit_us;
+}
+
+// Parallellt och sekventiellt läge läser alla tre fälten i samma transaktion
+static size_t async_field_len(const bme680_t *sensor) {
+    return (sensor->async.mode == ASYNC_MODE_SCAN_PARALLEL || sensor->async.mode == ASYNC_MODE_LATEST) ?
+           BME68X_LEN_FIELD * 3 : BME68X_LEN_FIELD;
+}
+
+static int64_t measure_alarm(alarm_id_t id, void *user_data);
+
+static bool measure_arm(bme680_t *sensor, uint32_t delay_us) {
+    sensor->async.state = ASYNC_MEASURING;
+    sensor->async.alarm = add_alarm_in_us(delay_us, measure_alarm, sensor, true);
+    if (sensor->async.alarm < 0) {
+        sensor->async.alarm = 0;
+        return false;
+    }
     return true;
 }
 
-// Läs sensorvärden
-bool bme680_read(float *temperature, float *humidity, float *pressure, float *gas) {
+// Statusbyten läst (avbrott): läs fälten om mätningen är klar, annars polla igen
+static void status_read_done(bool ok, void *user_data) {
+    bme680_t *sensor = user_data;
+    uint32_t delay_us = ADAPT_POLL_US;
+
+    if (!ok || async_overdue(sensor)) {
+        field_read_done(false, sensor); // Bussfel, eller sensorn blev aldrig klar
+        return;
+    }
+
+    if (sensor->async.status & BME68X_NEW_DATA_MSK) {
+        sensor->async.polling = false;
+        sensor->async.state = ASYNC_READING;
+        if (i2c_dma_read_reg_async(sensor->i2c, sensor->addr, BME68X_REG_FIELD0, sensor->async.field,
+                                   async_field_len(sensor), field_read_done, sensor)) {
+            return;
+        }
+        delay_us = ASYNC_BUS_RETRY_US;
+    }
+
+    if (!measure_arm(sensor, delay_us)) field_read_done(false, sensor);
+}
+
+// Timeralarm (avbrott): läs fältregistren, eller bara statusbyten om vi redan
+// vet att mätningen inte var klar vid förra läsningen
+static int64_t measure_alarm(alarm_id_t id, void *user_data) {
+    bme680_t *sensor = user_data;
+    bool started;
+
+    if (sensor->async.polling) {
+        sensor->async.state = ASYNC_POLLING;
+        started = i2c_dma_read_reg_async(sensor->i2c, sensor->addr, BME68X_REG_FIELD0, &sensor->async.status,
+                                         1, status_read_done, sensor);
+    } else {
+        sensor->async.state = ASYNC_READING;
+        started = i2c_dma_read_reg_async(sensor->i2c, sensor->addr, BME68X_REG_FIELD0, sensor->async.field,
+                                         async_field_len(sensor), field_read_done, sensor);
+    }
+    if (!started) {
+        // Bussen upptagen (t.ex. en annan sensor läses), försök igen strax
+        sensor->async.state = ASYNC_MEASURING;
+        return ASYNC_BUS_RETRY_US;
+    }
+    sensor->async.alarm = 0;
+    return 0;
+}
+
+// Mätningar med och utan värmare har var sin inlärd väntetid
+static bme680_timing_t *async_timing(bme680_t *sensor) {
+    return sensor->async.gas ? &sensor->session.timing : &sensor->session.tph_timing;
+}
+
+// Uppdatera histogrammet och den inlärda väntetiden efter en lyckad mätning
+static void timing_update(bme680_t *sensor) {
+    bme680_timing_t *t = async_timing(sensor);
+    uint32_t latency_us = sensor->async.done_us - sensor->async.trigger_us;
+    uint32_t floor_us = (sensor->async.gas ? sensor->session.heat_dur_us : 0) + ADAPT_MARGIN_US;
+    uint32_t bucket = latency_us / BME680_TIMING_BUCKET_US;
+
+    if (bucket >= BME680_TIMING_BUCKETS) bucket = BME680_TIMING_BUCKETS - 1;
+    if (t->hist[bucket] < UINT16_MAX) t->hist[bucket]++;
+    t->last_us = latency_us;
+    t->samples++;
+
+    if (sensor->async.early) {
+        // För tidigt: vänta till observerad klartid plus marginal nästa gång
+        t->early++;
+        t->learned = true;
+        t->hits = 0;
+        t->expect_us = latency_us + ADAPT_MARGIN_US;
+        if (t->expect_us > t->worst_us) t->expect_us = t->worst_us;
+    } else if (!t->learned || ++t->hits >= ADAPT_SHRINK_HITS) {
+        // Träff: pröva att läsa lite tidigare. Innan första missen krymps
+        // väntan snabbt (en åttondel av avståndet till golvet per mätning).
+        uint32_t step = t->learned ? ADAPT_STEP_US : (t->expect_us - floor_us) / 8;
+        if (step < ADAPT_STEP_US) step = ADAPT_STEP_US;
+        t->hits = 0;
+        t->expect_us = (t->expect_us > floor_us + step) ? t->expect_us - step : floor_us;
+    }
+}
+
+static void async_finish(bme680_t *sensor, bool ok, const bme680_reading_t *reading) {
+    bme680_read_cb_t cb = sensor->async.cb;
+
+    sensor->async.state = ASYNC_IDLE;
+    sensor->async.cb = NULL;
+    if (cb) cb(sensor, ok, reading, sensor->async.user_data);
+}
+
+// Profilskanning. BME688 kör hela profilen i parallellt läge: sensorn gör en
+// TPHG-mätning per cykel och värmarsteget byts enligt profilen, så vi läser alla
+// tre fälten en gång per cykel och sorterar in gasvärdena efter gas_index.
+// BME680 har bara forced mode, där körs ett steg per forced-mätning.
+
+static void scan_finish(bme680_t *sensor, bool ok) {
+    bme680_scan_t *r = &sensor->scan.result;
+    bme680_scan_cb_t cb = sensor->scan.cb;
+
+    // Parallellt läge fortsätter tills vi stoppar det. Sessionens forced-
+    // konfiguration skrivs tillbaka vid nästa vanliga mätning.
+    if (sensor->async.mode == ASYNC_MODE_SCAN_PARALLEL) bme68x_set_op_mode(BME68X_SLEEP_MODE, &sensor->dev);
+    sensor->session.applied = false;
+
+    r->duration_us = time_us_32() - sensor->scan.start_us;
+    sensor->async.state = ASYNC_IDLE;
+    sensor->async.mode = ASYNC_MODE_READ;
+    sensor->scan.cb = NULL;
+    if (cb) cb(sensor, ok, ok ? r : NULL, sensor->scan.user_data);
+}
+
+// Spara ett fält i resultatet. Gasvärdet räknas bara om värmaren hann bli stabil.
+static void scan_record(bme680_t *sensor, const struct bme68x_data *data, uint8_t step) {
+    bme680_scan_t *r = &sensor->scan.result;
+
+    data_to_reading(data, &r->tph);
+    if (step < r->len && (data->status & BME68X_GASM_VALID_MSK) && (data->status & BME68X_HEAT_STAB_MSK)) {
+        r->gas[step] = r->tph.gas;
+        r->valid |= (uint16_t)(1u << step);
+    }
+}
+
+// BME680: ställ in värmaren för aktuellt steg och trigga en forced-mätning
+static bool scan_forced_step(bme680_t *sensor) {
+    const bme680_profile_t *p = &sensor->scan.profile;
+    struct bme68x_heatr_conf heatr = {
+        .enable = BME68X_ENABLE,
+        .heatr_temp = p->temp[sensor->scan.step],
+        .heatr_dur = p->dur[sensor->scan.step],
+    };
+    uint32_t wait_us = sensor->session.meas_dur_us + (uint32_t)heatr.heatr_dur * 1000;
+
+    if (bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr, &sensor->dev) != BME68X_OK) return false;
+    if (bme68x_set_op_mode(BME68X_FORCED_MODE, &sensor->dev) != BME68X_OK) return false;
+
+    sensor->async.trigger_us = time_us_32();
+    sensor->async.limit_us = wait_us + ASYNC_OVERRUN_US;
+    sensor->async.polling = false;
+    return measure_arm(sensor, wait_us);
+}
+
+// BME688: starta hela profilen i parallellt läge
+static bool scan_parallel_start(bme680_t *sensor) {
+    const bme680_profile_t *p = &sensor->scan.profile;
+    struct bme68x_conf conf = sensor->session.conf;
+    uint32_t meas_us = bme68x_get_meas_dur(BME68X_PARALLEL_MODE, &conf, &sensor->dev);
+    uint16_t shared_ms = p->shared_dur_ms;
+    uint32_t cycles = 0;
+
+    // Värmaren är på under hela cykeln, även under TPH-mätningen. Välj cykeln så
+    // att det kortaste steget (minst antal cykler) får BME680_SCAN_HEAT_MS.
+    if (shared_ms == 0) {
+        uint16_t min_dur = UINT16_MAX;
+        uint32_t cycle_ms;
+
+        for (uint8_t i = 0; i < p->len; i++) {
+            if (p->dur[i] > 0 && p->dur[i] < min_dur) min_dur = p->dur[i];
+        }
+        if (min_dur == UINT16_MAX) min_dur = 1;
+        cycle_ms = (BME680_SCAN_HEAT_MS + min_dur - 1) / min_dur;
+        shared_ms = (cycle_ms > meas_us / 1000 + 1) ? (uint16_t)(cycle_ms - meas_us / 1000) : 1;
+    }
+
+    struct bme68x_heatr_conf heatr = {
+        .enable = BME68X_ENABLE,
+        .heatr_temp_prof = sensor->scan.profile.temp,
+        .heatr_dur_prof = sensor->scan.profile.dur,
+        .profile_len = p->len,
+        .shared_heatr_dur = shared_ms,
+    };
+
+    if (bme68x_set_heatr_conf(BME68X_PARALLEL_MODE, &heatr, &sensor->dev) != BME68X_OK) return false;
+    if (bme68x_set_op_mode(BME68X_PARALLEL_MODE, &sensor->dev) != BME68X_OK) return false;
+
+    for (uint8_t i = 0; i < p->len; i++) cycles += p->dur[i];
+
+    sensor->scan.cycle_us = meas_us + (uint32_t)shared_ms * 1000;
+    sensor->async.trigger_us = time_us_32();
+    sensor->async.limit_us = (cycles + 2) * sensor->scan.cycle_us + ASYNC_OVERRUN_US;
+    sensor->async.polling = false;
+    return measure_arm(sensor, sensor->scan.cycle_us);
+}
+
+static void scan_task(bme680_t *sensor) {
+    bme680_scan_t *r = &sensor->scan.result;
+    uint16_t all = (uint16_t)((1u << r->len) - 1);
+
+    if (!sensor->async.xfer_ok) {
+        scan_finish(sensor, false);
+        return;
+    }
+
+    if (sensor->async.mode == ASYNC_MODE_SCAN_PARALLEL) {
+        struct bme68x_data data[3];
+        uint8_t n_fields = 0;
+        int8_t rslt = bme68x_parse_all_field_data(sensor->async.field, data, &n_fields, &sensor->dev);
+
+        if (rslt < BME68X_OK) {
+            scan_finish(sensor, false);
+            return;
+        }
+        for (uint8_t i = 0; i < n_fields; i++) scan_record(sensor, &data[i], data[i].gas_index);
+
+        if (r->valid == all) {
+            scan_finish(sensor, true);
+        } else if (async_overdue(sensor)) {
+            scan_finish(sensor, r->valid != 0); // Delresultat, valid visar vilka steg som kom
+        } else if (!measure_arm(sensor, sensor->scan.cycle_us)) {
+            scan_finish(sensor, false);
+        }
+        return;
+    }
+
     struct bme68x_data data;
+    int8_t rslt = bme68x_parse_field_data(sensor->async.field, &data, &sensor->dev);
+
+    if (rslt == BME68X_OK) {
+        scan_record(sensor, &data, sensor->scan.step);
+        if (++sensor->scan.step >= r->len) {
+            scan_finish(sensor, true);
+        } else if (!scan_forced_step(sensor)) {
+            scan_finish(sensor, false);
+        }
+    } else if (rslt == BME68X_W_NO_NEW_DATA && !async_overdue(sensor)) {
+        sensor->async.polling = true;
+        if (!measure_arm(sensor, ADAPT_POLL_US)) scan_finish(sensor, false);
+    } else {
+        scan_finish(sensor, false);
+    }
+}
+
+bool bme680_scan_async(bme680_t *sensor, const bme680_profile_t *profile, bme680_scan_cb_t cb, void *user_data) {
+    bool started;
+
+    bme680_async_task(sensor);
+    if (sensor->async.state != ASYNC_IDLE || sensor->continuous) return false;
+    if (!profile || profile->len == 0 || profile->len > BME680_PROFILE_MAX_STEPS) return false;
+    if (!sensor->session.applied && !session_apply(sensor)) return false;
+
+    sensor->scan.profile = *profile;
+    memset(&sensor->scan.result, 0, sizeof(sensor->scan.result));
+    sensor->scan.result.len = profile->len;
+    sensor->scan.step = 0;
+    sensor->scan.cb = cb;
+    sensor->scan.user_data = user_data;
+    sensor->scan.start_us = time_us_32();
+    sensor->async.cb = NULL;
+
+    if (sensor->dev.variant_id == BME68X_VARIANT_GAS_HIGH) {
+        sensor->async.mode = ASYNC_MODE_SCAN_PARALLEL;
+        started = scan_parallel_start(sensor);
+    } else {
+        sensor->async.mode = ASYNC_MODE_SCAN_FORCED;
+        started = scan_forced_step(sensor);
+    }
+
+    if (!started) {
+        sensor->async.state = ASYNC_IDLE;
+        sensor->async.mode = ASYNC_MODE_READ;
+        sensor->session.applied = false;
+        sensor->scan.cb = NULL;
+    }
+    return started;
+}
+
+// Kontinuerligt läge: sensorn har redan mätt, läs alla tre fälten direkt
+static bool latest_start(bme680_t *sensor) {
+    sensor->async.mode = ASYNC_MODE_LATEST;
+    sensor->async.trigger_us = time_us_32();
+    sensor->async.limit_us = ASYNC_LATEST_LIMIT_US;
+    sensor->async.polling = false;
+    sensor->async.state = ASYNC_READING;
+    if (i2c_dma_read_reg_async(sensor->i2c, sensor->addr, BME68X_REG_FIELD0, sensor->async.field,
+                               BME68X_LEN_FIELD * 3, field_read_done, sensor)) {
+        return true;
+    }
+    // Bussen upptagen, låt alarmet göra läsningen strax
+    return measure_arm(sensor, ASYNC_BUS_RETRY_US);
+}
+
+// Nyaste fältet med ny data är senaste värdet. Har sensorn inte hunnit mäta
+// sedan förra läsningen återanvänds det förra.
+static void latest_task(bme680_t *sensor) {
+    struct bme68x_data data[3];
     uint8_t n_fields = 0;
-    
-    // Konfigurera sensorn för att mäta
-    struct bme68x_conf conf;
-    conf.filter = BME68X_FILTER_OFF;
-    conf.odr = BME68X_ODR_NONE;
-    conf.os_hum = BME68X_OS_16X;
-    conf.os_pres = BME68X_OS_1X;
-    conf.os_temp = BME68X_OS_2X;
-    if (bme68x_set_conf(&conf, &gas_sensor) != BME68X_OK) return false;
-
-    // 2. Konfigurera Värmaren (Detta är NYTT!)
-    struct bme68x_heatr_conf heatr_conf;
-    heatr_conf.enable = BME68X_ENABLE;       // Slå PÅ värmaren
-    heatr_conf.heatr_temp = 320;             // Värm till 320 grader
-    heatr_conf.heatr_dur = 150;              // Håll i 150 ms
-    if (bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &gas_sensor) != BME68X_OK) {
+    int8_t rslt = BME68X_E_COM_FAIL;
+
+    if (sensor->async.xfer_ok) {
+        rslt = bme68x_parse_all_field_data(sensor->async.field, data, &n_fields, &sensor->dev);
+    }
+    if (rslt == BME68X_OK && n_fields > 0) {
+        // Fälten är sorterade på mätindex, sista nya fältet är nyast
+        data_to_reading(&data[n_fields - 1], &sensor->latest);
+        sensor->latest.seq = ++sensor->seq;
+        sensor->latest_valid = true;
+    }
+
+    if (rslt < BME68X_OK) {
+        async_finish(sensor, false, NULL);
+    } else if (sensor->latest_valid) {
+        async_finish(sensor, true, &sensor->latest);
+    } else if (async_overdue(sensor) || !measure_arm(sensor, BME68X_PERIOD_POLL)) {
+        // Första mätningen efter start är inte klar än, titta igen om en stund
+        async_finish(sensor, false, NULL);
+    }
+}
+
+// Slå på eller av värmaren inför nästa forced-mätning. Värmarregistren är
+// oförändrade, så registerskuggan skriver bara CTRL_GAS_0/1 i en transaktion.
+static bool heater_set(bme680_t *sensor, bool on) {
+    bme680_session_t *s = &sensor->session;
+    struct bme68x_heatr_conf heatr = s->heatr_conf;
+
+    on = on && heatr.enable == BME68X_ENABLE;
+    if (s->heater_on == on) return true;
+    if (!on) heatr.enable = BME68X_DISABLE;
+    if (bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr, &sensor->dev) != BME68X_OK) {
+        s->applied = false;
+        return false;
+    }
+    s->heater_on = on;
+    return true;
+}
+
+// Starta en forced-mätning, med eller utan gas
+static bool read_start(bme680_t *sensor, bool gas, bme680_read_cb_t cb, void *user_data) {
+    bme680_session_t *s = &sensor->session;
+
+    // Lämna över en färdig läsning som ingen hämtat än (t.ex. efter timeout i bme680_read)
+    bme680_async_task(sensor);
+    if (sensor->async.state != ASYNC_IDLE) return false;
+
+    if (sensor->continuous) {
+        sensor->async.cb = cb;
+        sensor->async.user_data = user_data;
+        if (!latest_start(sensor)) {
+            sensor->async.state = ASYNC_IDLE;
+            return false;
+        }
+        return true;
+    }
+
+    if (!s->applied && !session_apply(sensor)) return false;
+    if (!heater_set(sensor, gas)) return false;
+
+    // Triggern är en kort skrivning, själva mätningen sköter sensorn själv
+    if (bme68x_set_op_mode(BME68X_FORCED_MODE, &sensor->dev) != BME68X_OK) return false;
+
+    sensor->async.cb = cb;
+    sensor->async.user_data = user_data;
+    sensor->async.mode = ASYNC_MODE_READ;
+    sensor->async.gas = s->heater_on;
+    sensor->async.trigger_us = time_us_32();
+    sensor->async.limit_us = async_timing(sensor)->worst_us + ASYNC_OVERRUN_US;
+    sensor->async.polling = false;
+    sensor->async.early = false;
+    if (!measure_arm(sensor, async_timing(sensor)->expect_us)) {
+        sensor->async.state = ASYNC_IDLE;
         return false;
     }
+    return true;
+}
+
+// Starta en mätning. Returnerar direkt, cb anropas från bme680_async_task() när värdena finns.
+bool bme680_read_async(bme680_t *sensor, bme680_read_cb_t cb, void *user_data) {
+    return read_start(sensor, true, cb, user_data);
+}
+
+bool bme680_read_tph_async(bme680_t *sensor, bme680_read_cb_t cb, void *user_data) {
+    return read_start(sensor, false, cb, user_data);
+}
+
+// Tolka fältdatat när alarmet och DMA-läsningen är klara. Anropa ofta från huvudloopen.
+void bme680_async_task(bme680_t *sensor) {
+    if (sensor->async.state != ASYNC_DONE) return;
+
+    if (sensor->async.mode == ASYNC_MODE_LATEST) {
+        latest_task(sensor);
+        return;
+    }
+    if (sensor->async.mode != ASYNC_MODE_READ) {
+        scan_task(sensor);
+        return;
+    }
+
+    if (!sensor->async.xfer_ok) {
+        async_finish(sensor, false, NULL);
+        return;
+    }
 
-    // Sätt forced mode för att läsa en gång
-    if (bme68x_set_op_mode(BME68X_FORCED_MODE, &gas_sensor) != BME68X_OK) return false;
+    struct bme68x_data data;
+    int8_t rslt = bme68x_parse_field_data(sensor->async.field, &data, &sensor->dev);
 
-    // 4. Beräkna väntetid (Mätning + Värmare) - HÄR ÄR SKILLNADEN
-    uint32_t meas_dur = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &gas_sensor);
-    uint32_t heat_dur = heatr_conf.heatr_dur * 1000; // ms till us
+    if (BME680_TRACE && rslt == BME68X_OK) trace_hex("field", sensor->async.field, BME68X_LEN_FIELD);
 
-    // Vi väntar tillräckligt länge för båda
-    gas_sensor.delay_us(meas_dur + heat_dur, gas_sensor.intf_ptr);
+    if (rslt == BME68X_OK) {
+        bme680_reading_t r;
+        timing_update(sensor);
+        data_to_reading(&data, &r);
+        r.seq = ++sensor->seq;
+        async_finish(sensor, true, &r);
+    } else if (rslt == BME68X_W_NO_NEW_DATA && !async_overdue(sensor)) {
+        // Läst för tidigt: polla statusbyten tätt tills mätningen är klar
+        sensor->async.early = true;
+        sensor->async.polling = true;
+        if (!measure_arm(sensor, ADAPT_POLL_US)) async_finish(sensor, false, NULL);
+    } else {
+        async_finish(sensor, false, NULL);
+    }
+}
 
+// Blockerande läsning ovanpå den asynkrona: resultatet hamnar här via read_blocking_cb
+typedef struct {
+    volatile bool done;
+    bool ok;
+    bme680_reading_t reading;
+} read_blocking_t;
 
+static void read_blocking_cb(bme680_t *sensor, bool ok, const bme680_reading_t *reading, void *user_data) {
+    read_blocking_t *res = user_data;
 
-    // Läs sensor
-    if (bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &gas_sensor) != BME68X_OK) return false;
-    
-    // n_fields > 0 kollar bara om *någon* data kom, men vi vill ha temp/hum/tryck
-    if (n_fields && (data.status & BME68X_NEW_DATA_MSK)) {
-        if (temperature) *temperature = data.temperature;
-        if (humidity)    *humidity    = data.humidity;
-        if (pressure)    *pressure    = data.pressure / 100.0f; // Pa → hPa
-        
-        // Nu kollar vi om gas-datan är giltig
-        if (gas) {
-            if (data.status & BME68X_GASM_VALID_MSK) {
-                *gas = (float)data.gas_resistance;
-            } else {
-                // Om mätningen misslyckades (t.ex. för kort väntetid), behåll gammalt eller 0
-                // Men eftersom vi väntade rätt tid ovan, borde detta funka!
-                *gas = 0.0f; 
+    res->ok = ok;
+    if (ok) res->reading = *reading;
+    res->done = true;
+}
+
+// Läs sensorvärden
+bool bme680_read(bme680_t *sensor, float *temperature, float *humidity, float *pressure, float *gas) {
+    read_blocking_t res = { .done = false };
+    const bme680_session_t *s = &sensor->session;
+
+    if (!bme680_read_async(sensor, read_blocking_cb, &res)) return false;
+
+    // Sov tills I2C-avbrottet (__sev) signalerar att fältdatat är läst. Deadline
+    // som skydd om bussen hänger sig: värsta fallet + alla omförsök.
+    absolute_time_t deadline = make_timeout_time_us(s->timing.worst_us + ASYNC_OVERRUN_US + 20000);
+    while (!res.done) {
+        bme680_async_task(sensor);
+        if (res.done) break;
+        if (best_effort_wfe_or_timeout(deadline)) {
+            // cb pekar på vår stack, koppla loss den innan vi går
+            sensor->async.cb = NULL;
+            // Pågående DMA (POLLING/READING) avslutas själv och städas av nästa bme680_read_async()
+            if ((sensor->async.state == ASYNC_MEASURING && cancel_alarm(sensor->async.alarm)) ||
+                sensor->async.state == ASYNC_DONE) {
+                sensor->async.state = ASYNC_IDLE;
             }
+            return false;
         }
-        return true;
     }
+    if (!res.ok) return false;
+
+    if (temperature) *temperature = res.reading.temperature / 100.0f;
+    if (humidity)    *humidity    = res.reading.humidity / 1000.0f;
+    if (pressure)    *pressure    = res.reading.pressure / 100.0f; // Pa → hPa
+    if (gas)         *gas         = (float)res.reading.gas;
+    return true;
+}
+
+bool bme680_async_busy(const bme680_t *sensor) {
+    return sensor->async.state != ASYNC_IDLE;
+}
+
+void bme680_group_init(bme680_group_t *group) {
+    memset(group, 0, sizeof(*group));
+}
+
+bool bme680_group_add(bme680_group_t *group, bme680_t *sensor) {
+    if (group->count >= BME680_MAX_SENSORS) return false;
+    group->sensors[group->count++] = sensor;
+    return true;
+}
 
+// Alla triggar går ut direkt efter varandra (några hundra us per sensor), så
+// värmarna och AD-omvandlingarna löper parallellt i sensorerna. Sensorer på
+// samma buss läses sedan efter varandra när bussen blir ledig, sensorer på
+// olika bussar läses samtidigt.
+size_t bme680_group_read_async(bme680_group_t *group, bme680_read_cb_t cb, void *user_data) {
+    size_t started = 0;
+
+    for (size_t i = 0; i < group->count; i++) {
+        if (bme680_read_async(group->sensors[i], cb, user_data)) started++;
+    }
+    return started;
+}
+
+size_t bme680_group_read_tph_async(bme680_group_t *group, bme680_read_cb_t cb, void *user_data) {
+    size_t started = 0;
+
+    for (size_t i = 0; i < group->count; i++) {
+        if (bme680_read_tph_async(group->sensors[i], cb, user_data)) started++;
+    }
+    return started;
+}
+
+void bme680_group_task(bme680_group_t *group) {
+    for (size_t i = 0; i < group->count; i++) {
+        bme680_async_task(group->sensors[i]);
+    }
+}
+
+bool bme680_group_busy(const bme680_group_t *group) {
+    for (size_t i = 0; i < group->count; i++) {
+        if (bme680_async_busy(group->sensors[i])) return true;
+    }
     return false;
-} 
+}
+
+bool bme680_continuous_start(bme680_t *sensor, uint8_t filter, uint8_t odr) {
+    bme680_session_t *s = &sensor->session;
+    struct bme68x_conf conf = s->conf;
+    bool seq = sensor->dev.variant_id == BME68X_VARIANT_GAS_HIGH;
+
+    if (bme680_async_busy(sensor)) return false;
+
+    // BME680 har inga ODR-bitar, där gäller bara filtret
+    conf.filter = filter;
+    conf.odr = seq ? odr : BME68X_ODR_NONE;
+    if (!bme680_configure(sensor, &conf, &s->heatr_conf)) return false;
+    if (!seq) return false;
+
+    // Sessionens värmarsteg upprepas i varje cykel
+    struct bme68x_heatr_conf heatr = {
+        .enable = s->heatr_conf.enable,
+        .heatr_temp_prof = &s->heatr_conf.heatr_temp,
+        .heatr_dur_prof = &s->heatr_conf.heatr_dur,
+        .profile_len = 1,
+    };
+    if (bme68x_set_heatr_conf(BME68X_SEQUENTIAL_MODE, &heatr, &sensor->dev) != BME68X_OK ||
+        bme68x_set_op_mode(BME68X_SEQUENTIAL_MODE, &sensor->dev) != BME68X_OK) {
+        s->applied = false;
+        return false;
+    }
+
+    sensor->continuous = true;
+    sensor->latest_valid = false;
+    return true;
+}
+
+bool bme680_continuous_stop(bme680_t *sensor) {
+    if (!sensor->continuous) return true;
+    if (bme680_async_busy(sensor)) return false;
+
+    // Forced-värmaren skrivs tillbaka vid nästa mätning
+    sensor->continuous = false;
+    sensor->session.applied = false;
+    return bme68x_set_op_mode(BME68X_SLEEP_MODE, &sensor->dev) == BME68X_OK;
+}
+
+static void print_timing(const bme680_t *sensor, const char *what, const bme680_timing_t *t) {
+    printf("BME680 i2c%u 0x%02x %s: värsta fall %lu us, väntar %lu us, senast %lu us, %lu mätningar (%lu för tidiga)\n",
+           (unsigned)i2c_hw_index(sensor->i2c), sensor->addr, what,
+           (unsigned long)t->worst_us, (unsigned long)t->expect_us, (unsigned long)t->last_us,
+           (unsigned long)t->samples, (unsigned long)t->early);
+    for (int i = 0; i < BME680_TIMING_BUCKETS; i++) {
+        if (!t->hist[i]) continue;
+        printf("  %3d-%3d ms: %u\n", i * BME680_TIMING_BUCKET_US / 1000,
+               (i + 1) * BME680_TIMING_BUCKET_US / 1000, t->hist[i]);
+    }
+}
+
+void bme680_print_timing(const bme680_t *sensor) {
+    print_timing(sensor, "TPHG", &sensor->session.timing);
+    if (sensor->session.tph_timing.samples) print_timing(sensor, "TPH", &sensor->session.tph_timing);
+}
@@ -6,11 +6,206 @@
 #include "bme68x.h"
 #include <stdbool.h>
 
-// Initiera BME680 på vald I2C instans och SDA/SCL pins
-bool bme680_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin);
+// I2C-hastighet. 400 kHz (fast mode) fungerar med breakout-kortens pull-ups,
+// 1000000 (Fast-mode Plus) kräver starkare pull-ups och korta ledningar.
+#ifndef BME680_I2C_BAUDRATE
+#define BME680_I2C_BAUDRATE 400000
+#endif
+
+// Max antal sensorer: 0x76/0x77 på både i2c0 och i2c1
+#define BME680_MAX_SENSORS 4
+
+// Latenshistogram: 2 ms per fack, sista facket tar allt över 254 ms
+#define BME680_TIMING_BUCKET_US 2000
+#define BME680_TIMING_BUCKETS 128
+
+// Inlärd mättid för en konfiguration. Första läsningen görs efter expect_us i
+// stället för värsta fallet; kommer den för tidigt pollas statusbyten tills
+// sensorn är klar och expect_us flyttas till den observerade tiden.
+typedef struct {
+    uint32_t worst_us;      // Värsta fallet: meas_dur_us + heat_dur_us
+    uint32_t expect_us;     // Inlärd väntetid innan fältdatat läses
+    uint32_t last_us;       // Senaste latens från trigger till färdigt resultat
+    uint32_t samples;       // Antal lyckade mätningar
+    uint32_t early;         // Varav läsningar som kom för tidigt och fick polla
+    uint8_t hits;           // Träffar i rad sedan expect_us senast krymptes
+    bool learned;           // true efter första för tidiga läsningen
+    uint16_t hist[BME680_TIMING_BUCKETS];
+} bme680_timing_t;
+
+// Mätsession: konfigurationen som ligger i sensorn och de cachade väntetiderna
+typedef struct {
+    struct bme68x_conf conf;
+    struct bme68x_heatr_conf heatr_conf;
+    uint32_t meas_dur_us;   // TPH-mätning enligt bme68x_get_meas_dur()
+    uint32_t heat_dur_us;   // Värmarens hålltid
+    bool applied;           // true när konfigurationen är skriven till sensorn
+    bool heater_on;         // Värmaren är påslagen i sensorn (av för T/H/P-mätningar)
+    bme680_timing_t timing; // Mätningar med gas. Nollställs när konfigurationen ändras.
+    bme680_timing_t tph_timing; // T/H/P-mätningar utan värmare
+} bme680_session_t;
+
+// Ett mätvärde från den asynkrona läsningen, i fixpunkt så att inget flyttal
+// behövs från rå-ADC till publicerat värde (se BME680_FIXED_POINT i CMakeLists.txt)
+typedef struct {
+    int32_t temperature;    // °C x100
+    uint32_t humidity;      // % x1000
+    uint32_t pressure;      // Pa (= hPa x100)
+    uint32_t gas;           // ohm, 0 om has_gas är false
+    uint32_t seq;           // Sensorns löpnummer för mätningen, för att para ihop T/H/P och gas
+    bool has_gas;           // Mätningen gjordes med värmaren och gasvärdet är giltigt
+    bool heat_stab;         // Värmaren nådde måltemperaturen (BME68X_HEAT_STAB_MSK)
+} bme680_reading_t;
+
+typedef struct bme680 bme680_t;
+
+// Anropas när en asynkron mätning är klar. reading är NULL om ok är false.
+typedef void (*bme680_read_cb_t)(bme680_t *sensor, bool ok, const bme680_reading_t *reading, void *user_data);
+
+// Värmarprofil för profilskanning, upp till 10 steg
+#define BME680_PROFILE_MAX_STEPS BME68X_MAX_PROFILE_LEN
+
+// Värmartid för profilens kortaste steg när shared_dur_ms är 0 (BME688)
+#define BME680_SCAN_HEAT_MS 50
+
+typedef struct {
+    uint16_t temp[BME680_PROFILE_MAX_STEPS];    // Värmartemperatur per steg (°C)
+    uint16_t dur[BME680_PROFILE_MAX_STEPS];     // BME688: antal TPHG-cykler per steg, BME680: ms
+    uint8_t len;                                // Antal steg
+    uint16_t shared_dur_ms;                     // BME688: värmartid per cykel, 0 = kortaste steget värms BME680_SCAN_HEAT_MS
+} bme680_profile_t;
+
+// Resultat av en profilskanning
+typedef struct {
+    bme680_reading_t tph;                       // Senaste T/H/P under skanningen
+    uint32_t gas[BME680_PROFILE_MAX_STEPS];     // Gasresistans per steg (ohm), 0 = ogiltig
+    uint16_t valid;                             // Bit n satt om steg n har giltig gas
+    uint8_t len;
+    uint32_t duration_us;                       // Hela skanningen, trigger till sista steget
+} bme680_scan_t;
+
+// Anropas när en profilskanning är klar. scan är NULL om ok är false.
+typedef void (*bme680_scan_cb_t)(bme680_t *sensor, bool ok, const bme680_scan_t *scan, void *user_data);
+
+// En sensor. Allokeras av anroparen (statiskt), fälten är privata för bme680.c.
+struct bme680 {
+    struct bme68x_dev dev;
+    i2c_inst_t *i2c;
+    uint8_t addr;
+    bme680_session_t session;
+    bool continuous;            // Sensorn mäter själv (sekventiellt läge, BME688)
+    uint32_t seq;               // Senaste löpnumret (bme680_reading_t.seq)
+    bool latest_valid;
+    bme680_reading_t latest;    // Senaste värdet i kontinuerligt läge
+    struct {
+        volatile uint8_t state;
+        uint8_t mode;           // Vanlig mätning eller profilskanning
+        volatile bool xfer_ok;
+        alarm_id_t alarm;       // Timeralarm för nästa läsning
+        uint32_t trigger_us;    // time_us_32() när forced mode sattes
+        uint32_t limit_us;      // Ge upp så här långt efter trigger_us
+        volatile uint32_t done_us; // time_us_32() när fältdatat var läst
+        bool polling;           // Nästa alarm läser bara statusbyten
+        bool early;             // Första läsningen kom före mätningens slut
+        bool gas;               // Mätningen görs med värmaren (annars bara T/H/P)
+        uint8_t status;         // Statusbyte (FIELD0) från pollningen
+        uint8_t field[BME68X_LEN_FIELD * 3]; // Tre fält i parallellt läge
+        bme680_read_cb_t cb;
+        void *user_data;
+    } async;
+    struct {
+        bme680_profile_t profile;
+        bme680_scan_t result;
+        uint8_t step;           // BME680: aktuellt steg
+        uint32_t cycle_us;      // BME688: tid per TPHG-cykel
+        uint32_t start_us;
+        bme680_scan_cb_t cb;
+        void *user_data;
+    } scan;
+};
+
+// Initiera en I2C-buss (pinnar och DMA) för sensorerna. En gång per buss.
+bool bme680_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin);
+
+// Initiera en sensor på en redan initierad buss. addr är BME68X_I2C_ADDR_LOW (0x76)
+// eller BME68X_I2C_ADDR_HIGH (0x77). Returnerar false om ingen sensor svarar.
+bool bme680_init(bme680_t *sensor, i2c_inst_t *i2c, uint8_t addr);
+
+// Byt mätkonfiguration. Skriver bara till sensorn om något har ändrats.
+bool bme680_configure(bme680_t *sensor, const struct bme68x_conf *conf, const struct bme68x_heatr_conf *heatr_conf);
+
+// Aktuell session (t.ex. för att läsa ut cachade väntetider)
+const bme680_session_t *bme680_get_session(const bme680_t *sensor);
+
+// Antal I2C-transaktioner som sparats tack vare registerskuggan i bme68x
+uint32_t bme680_saved_transfers(const bme680_t *sensor);
+
+// Läs sensorvärden: temperatur (°C), luftfuktighet (%), tryck (hPa), gas (ohm).
+// Går via den asynkrona mätningen och sover med __wfe() tills värdena finns.
+bool bme680_read(bme680_t *sensor, float *temperature, float *humidity, float *pressure, float *gas);
+
+// Starta en mätning utan att blockera. Ett timeralarm startar DMA-läsningen när
+// mätningen är klar. I kontinuerligt läge läses bara senaste fältet direkt,
+// utan trigger. Returnerar false om en mätning redan pågår.
+bool bme680_read_async(bme680_t *sensor, bme680_read_cb_t cb, void *user_data);
+
+// Multi-rate: som bme680_read_async() men med värmaren avslagen, så mätningen
+// tar bara T/H/P-tiden (ca 40 ms mot ca 190 ms med standardkonfigurationen) och
+// värmaren drar ingen ström. reading->has_gas är false och gas 0. Värmaren slås
+// på igen av nästa bme680_read_async(); bytet är en enda registerskrivning.
+bool bme680_read_tph_async(bme680_t *sensor, bme680_read_cb_t cb, void *user_data);
+
+// Ta hand om en färdig läsning; cb anropas härifrån (inte från avbrott). Billig att anropa ofta.
+void bme680_async_task(bme680_t *sensor);
+
+// true medan en asynkron mätning pågår
+bool bme680_async_busy(const bme680_t *sensor);
+
+// Kontinuerligt läge: sensorn mäter själv med intervallet odr (BME68X_ODR_*) och
+// sensorns IIR-filter (BME68X_FILTER_*) jämnar ut temperatur och tryck.
+// bme680_read_async() blir då en enda DMA-läsning av fältregistren utan trigger
+// eller väntan. Bara BME688 har kontinuerligt (sekventiellt) läge; på BME680
+// sätts filtret och mätningarna fortsätter i forced mode. Returnerar true om
+// sensorn mäter kontinuerligt.
+bool bme680_continuous_start(bme680_t *sensor, uint8_t filter, uint8_t odr);
+
+// Tillbaka till forced mode (sensorn sover mellan mätningarna)
+bool bme680_continuous_stop(bme680_t *sensor);
+
+// Kör en värmarprofil och samla gasresistansen för varje steg. På BME688 körs
+// hela profilen i parallellt läge med gemensam värmartid och alla fält läses i
+// samma svep (tre fält per läsning). BME680 saknar parallellt läge, där körs
+// stegen som forced-mätningar efter varandra. cb anropas från bme680_async_task().
+// Nästa vanliga mätning skriver tillbaka sessionens konfiguration.
+bool bme680_scan_async(bme680_t *sensor, const bme680_profile_t *profile, bme680_scan_cb_t cb, void *user_data);
+
+// Skriv ut inlärd väntetid och latenshistogram för sensorns aktuella konfiguration
+void bme680_print_timing(const bme680_t *sensor);
+
+// Sensorgrupp: alla sensorer triggas i samma svep så att deras värme- och
+// mätfönster överlappar, sedan läses de i tur och ordning när de blir klara.
+// En cykel tar då ungefär lika lång tid som en enda sensors mätning.
+typedef struct {
+    bme680_t *sensors[BME680_MAX_SENSORS];
+    size_t count;
+} bme680_group_t;
+
+void bme680_group_init(bme680_group_t *group);
+
+// Lägg till en initierad sensor. Returnerar false om gruppen är full.
+bool bme680_group_add(bme680_group_t *group, bme680_t *sensor);
+
+// Trigga alla sensorer. cb anropas en gång per sensor. Returnerar antal startade mätningar.
+size_t bme680_group_read_async(bme680_group_t *group, bme680_read_cb_t cb, void *user_data);
+
+// Som bme680_group_read_async() men bara T/H/P, utan värmare
+size_t bme680_group_read_tph_async(bme680_group_t *group, bme680_read_cb_t cb, void *user_data);
+
+// Driv alla sensorers mätningar framåt
+void bme680_group_task(bme680_group_t *group);
 
-// Läs sensorvärden: temperatur (°C), luftfuktighet (%), tryck (hPa), gas (ohm)
-bool bme680_read(float *temperature, float *humidity, float *pressure, float *gas);
+// true så länge någon sensor i gruppen mäter
+bool bme680_group_busy(const bme680_group_t *group);
 
 #endif
 
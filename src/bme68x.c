@@ -37,10 +37,12 @@
 */
 
 #include "bme68x.h"
+#include "bme68x_tables.h"
 #include <stdio.h>
+#include <string.h>
 
-/* This internal API is used to read the calibration coefficients */
-static int8_t get_calib_data(struct bme68x_dev *dev);
+/* This internal API is used to decode the calibration coefficients */
+static void parse_calib_data(const uint8_t *coeff_array, struct bme68x_dev *dev);
 
 /* This internal API is used to read variant ID information register status */
 static int8_t read_variant_id(struct bme68x_dev *dev);
@@ -48,6 +50,9 @@ static int8_t read_variant_id(struct bme68x_dev *dev);
 /* This internal API is used to calculate the gas wait */
 static uint8_t calc_gas_wait(uint16_t dur);
 
+/* This internal API is used to get the heater resistance from the cache, calculating it on a miss */
+static uint8_t get_res_heat(uint16_t temp, struct bme68x_dev *dev);
+
 #ifndef BME68X_USE_FPU
 
 /* This internal API is used to calculate the temperature in integer */
@@ -66,7 +71,7 @@ static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range
 static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev);
 
 /* This internal API is used to calculate the heater resistance using integer */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
+static uint8_t calc_res_heat(uint16_t temp, int8_t amb_temp, const struct bme68x_dev *dev);
 
 #else
 
@@ -86,16 +91,53 @@ static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range);
 static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev);
 
 /* This internal API is used to calculate the heater resistance value using float */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
+static uint8_t calc_res_heat(uint16_t temp, int8_t amb_temp, const struct bme68x_dev *dev);
+
+/* This internal API is used to derive the float compensation terms from the calibration coefficients */
+static void calc_derived_calib(struct bme68x_calib_data *calib);
 
 #endif
 
 /* This internal API is used to read a single data of the sensor */
 static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bme68x_dev *dev);
 
+/* This internal API is used to decode the status byte and indexes of a field */
+static void parse_field_status(const uint8_t *buff, struct bme68x_data *data, const struct bme68x_dev *dev);
+
+/* This internal API is used to compensate the raw data of a field */
+static void calc_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev);
+
+/* This internal API is used to get res_heat, idac and gas_wait of the heater step used by a field */
+static int8_t get_heatr_meta(struct bme68x_data *data, uint8_t legacy_xfers, struct bme68x_dev *dev);
+
 /* This internal API is used to read all data fields of the sensor */
 static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme68x_dev *dev);
 
+/*
+ * @brief This internal API is used to decode and compensate the three fields
+ * of a parallel or sequential mode read
+ *
+ * @param[in] buff      : BME68X_LEN_FIELD * 3 bytes read from the field registers
+ * @param[out] data     : Structure instances to hold the data
+ * @param[in,out] dev   : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+static int8_t parse_all_field_data(const uint8_t *buff, struct bme68x_data * const data[], struct bme68x_dev *dev);
+
+/*
+ * @brief This internal API is used to count the new fields and copy them
+ * sorted by measurement index
+ *
+ * @param[in,out] field : Pointers to the three decoded fields, reordered
+ * @param[out] data     : Array of three structure instances for the sorted data
+ *
+ * @return Number of fields holding new data
+ */
+static uint8_t collect_new_fields(struct bme68x_data *field[], struct bme68x_data *data);
+
 /* This internal API is used to switch between SPI memory pages */
 static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev);
 
@@ -105,8 +147,30 @@ static int8_t get_mem_page(struct bme68x_dev *dev);
 /* This internal API is used to check the bme68x_dev for null pointers */
 static int8_t null_ptr_check(const struct bme68x_dev *dev);
 
-/* This internal API is used to set heater configurations */
-static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, uint8_t *nb_conv, struct bme68x_dev *dev);
+/* This internal API is used to build the heater configuration registers */
+static int8_t set_conf(const struct bme68x_heatr_conf *conf,
+                       uint8_t op_mode,
+                       uint8_t *nb_conv,
+                       uint8_t *reg_addr,
+                       uint8_t *reg_data,
+                       uint8_t *len,
+                       struct bme68x_dev *dev);
+
+/* This internal API is used to load a register bank into the shadow */
+static int8_t shadow_fill(uint8_t bank, uint8_t legacy_xfers, struct bme68x_dev *dev);
+
+/* This internal API is used to update the shadow after a register write */
+static void shadow_update(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
+
+/* This internal API is used to write only the registers that differ from the shadow */
+static int8_t shadow_write(const uint8_t *reg_addr,
+                           const uint8_t *reg_data,
+                           uint8_t len,
+                           uint8_t *n_xfers,
+                           struct bme68x_dev *dev);
+
+/* This internal API is used to read CTRL_MEAS, from the shadow when its content is known */
+static int8_t get_ctrl_meas(uint8_t *ctrl_meas, uint8_t use_shadow, struct bme68x_dev *dev);
 
 /* This internal API is used to limit the max value of a parameter */
 static int8_t boundary_check(uint8_t *value, uint8_t max, struct bme68x_dev *dev);
@@ -142,6 +206,29 @@ static int8_t analyze_sensor_data(const struct bme68x_data *data, uint8_t n_meas
 * As this API is the entry point, call this API before using other APIs.
 */
 int8_t bme68x_init(struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t coeff_array[BME68X_LEN_COEFF_ALL];
+
+    rslt = bme68x_probe(dev);
+    if (rslt == BME68X_OK)
+    {
+        /* Get the Calibration data */
+        rslt = bme68x_get_calib_raw(coeff_array, dev);
+    }
+
+    if (rslt == BME68X_OK)
+    {
+        rslt = bme68x_set_calib_raw(coeff_array, dev);
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API resets the sensor and reads its chip id and variant id
+ */
+int8_t bme68x_probe(struct bme68x_dev *dev)
 {
     int8_t rslt;
 
@@ -155,12 +242,6 @@ int8_t bme68x_init(struct bme68x_dev *dev)
         {
             /* Read Variant ID */
             rslt = read_variant_id(dev);
-
-            if (rslt == BME68X_OK)
-            {
-                /* Get the Calibration data */
-                rslt = get_calib_data(dev);
-            }
         }
         else
         {
@@ -171,6 +252,55 @@ int8_t bme68x_init(struct bme68x_dev *dev)
     return rslt;
 }
 
+/*
+ * @brief This API reads the raw calibration coefficients of the sensor
+ */
+int8_t bme68x_get_calib_raw(uint8_t *coeff_array, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    if (coeff_array == NULL)
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+    rslt = bme68x_get_regs(BME68X_REG_COEFF1, coeff_array, BME68X_LEN_COEFF1, dev);
+    if (rslt == BME68X_OK)
+    {
+        rslt = bme68x_get_regs(BME68X_REG_COEFF2, &coeff_array[BME68X_LEN_COEFF1], BME68X_LEN_COEFF2, dev);
+    }
+
+    if (rslt == BME68X_OK)
+    {
+        rslt = bme68x_get_regs(BME68X_REG_COEFF3,
+                               &coeff_array[BME68X_LEN_COEFF1 + BME68X_LEN_COEFF2],
+                               BME68X_LEN_COEFF3,
+                               dev);
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API loads raw calibration coefficients, e.g. from a copy kept in flash
+ */
+int8_t bme68x_set_calib_raw(const uint8_t *coeff_array, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (coeff_array != NULL))
+    {
+        parse_calib_data(coeff_array, dev);
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API writes the given data to the register address of the sensor
  */
@@ -213,6 +343,10 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
                 {
                     rslt = BME68X_E_COM_FAIL;
                 }
+                else
+                {
+                    shadow_update(reg_addr, reg_data, len, dev);
+                }
             }
         }
         else
@@ -288,6 +422,9 @@ int8_t bme68x_soft_reset(struct bme68x_dev *dev)
         {
             rslt = bme68x_set_regs(&reg_addr, &soft_rst_cmd, 1, dev);
 
+            /* All registers are back at their reset values */
+            dev->shadow.valid = 0;
+
             if (rslt == BME68X_OK)
             {
                 /* Wait for 5ms */
@@ -313,6 +450,7 @@ int8_t bme68x_set_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
     int8_t rslt;
     uint8_t odr20 = 0, odr3 = 1;
     uint8_t current_op_mode;
+    uint8_t n_xfers = 0;
 
     /* Register data starting from BME68X_REG_CTRL_GAS_1(0x71) up to BME68X_REG_CONFIG(0x75) */
     uint8_t reg_array[BME68X_LEN_CONFIG] = { 0x71, 0x72, 0x73, 0x74, 0x75 };
@@ -331,8 +469,13 @@ int8_t bme68x_set_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
     }
     else if (rslt == BME68X_OK)
     {
-        /* Read the whole configuration and write it back once later */
-        rslt = bme68x_get_regs(reg_array[0], data_array, BME68X_LEN_CONFIG, dev);
+        /* Take the whole configuration from the shadow and write it back once later */
+        rslt = shadow_fill(BME68X_SHADOW_CTRL, 1, dev);
+        if (rslt == BME68X_OK)
+        {
+            memcpy(data_array, &dev->shadow.ctrl[BME68X_REG_CTRL_GAS_1 - BME68X_REG_CTRL_GAS_0], BME68X_LEN_CONFIG);
+        }
+
         dev->info_msg = BME68X_OK;
         if (rslt == BME68X_OK)
         {
@@ -378,7 +521,11 @@ int8_t bme68x_set_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
 
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_set_regs(reg_array, data_array, BME68X_LEN_CONFIG, dev);
+        rslt = shadow_write(reg_array, data_array, BME68X_LEN_CONFIG, &n_xfers, dev);
+        if (n_xfers == 0)
+        {
+            dev->shadow.saved_xfers++;
+        }
     }
 
     if ((current_op_mode != BME68X_SLEEP_MODE) && (rslt == BME68X_OK))
@@ -396,11 +543,14 @@ int8_t bme68x_get_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
 {
     int8_t rslt;
 
-    /* starting address of the register array for burst read*/
-    uint8_t reg_addr = BME68X_REG_CTRL_GAS_1;
     uint8_t data_array[BME68X_LEN_CONFIG];
 
-    rslt = bme68x_get_regs(reg_addr, data_array, 5, dev);
+    rslt = shadow_fill(BME68X_SHADOW_CTRL, 1, dev);
+    if (rslt == BME68X_OK)
+    {
+        memcpy(data_array, &dev->shadow.ctrl[BME68X_REG_CTRL_GAS_1 - BME68X_REG_CTRL_GAS_0], BME68X_LEN_CONFIG);
+    }
+
     if (!conf)
     {
         rslt = BME68X_E_NULL_PTR;
@@ -433,11 +583,12 @@ int8_t bme68x_set_op_mode(const uint8_t op_mode, struct bme68x_dev *dev)
     uint8_t tmp_pow_mode;
     uint8_t pow_mode = 0;
     uint8_t reg_addr = BME68X_REG_CTRL_MEAS;
+    uint8_t use_shadow = BME68X_ENABLE;
 
     /* Call until in sleep */
     do
     {
-        rslt = bme68x_get_regs(BME68X_REG_CTRL_MEAS, &tmp_pow_mode, 1, dev);
+        rslt = get_ctrl_meas(&tmp_pow_mode, use_shadow, dev);
         if (rslt == BME68X_OK)
         {
             /* Put to sleep before changing mode */
@@ -447,6 +598,9 @@ int8_t bme68x_set_op_mode(const uint8_t op_mode, struct bme68x_dev *dev)
                 tmp_pow_mode &= ~BME68X_MODE_MSK; /* Set to sleep */
                 rslt = bme68x_set_regs(&reg_addr, &tmp_pow_mode, 1, dev);
                 dev->delay_us(BME68X_PERIOD_POLL, dev->intf_ptr);
+
+                /* Confirm on the sensor that the sleep mode was reached */
+                use_shadow = BME68X_DISABLE;
             }
         }
     } while ((pow_mode != BME68X_SLEEP_MODE) && (rslt == BME68X_OK));
@@ -471,7 +625,7 @@ int8_t bme68x_get_op_mode(uint8_t *op_mode, struct bme68x_dev *dev)
 
     if (op_mode)
     {
-        rslt = bme68x_get_regs(BME68X_REG_CTRL_MEAS, &mode, 1, dev);
+        rslt = get_ctrl_meas(&mode, BME68X_ENABLE, dev);
 
         /* Masking the other register bit info*/
         *op_mode = mode & BME68X_MODE_MSK;
@@ -540,7 +694,7 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev)
 {
     int8_t rslt;
-    uint8_t i = 0, j = 0, new_fields = 0;
+    uint8_t new_fields = 0;
     struct bme68x_data *field_ptr[3] = { 0 };
     struct bme68x_data field_data[3] = { { 0 } };
 
@@ -560,6 +714,9 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
                 if (data->status & BME68X_NEW_DATA_MSK)
                 {
                     new_fields = 1;
+
+                    /* The sensor went back to sleep when the forced measurement completed */
+                    dev->shadow.ctrl[BME68X_REG_CTRL_MEAS - BME68X_REG_CTRL_GAS_0] &= ~BME68X_MODE_MSK;
                 }
                 else
                 {
@@ -570,31 +727,13 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
         }
         else if ((op_mode == BME68X_PARALLEL_MODE) || (op_mode == BME68X_SEQUENTIAL_MODE))
         {
-            /* Read the 3 fields and count the number of new data fields */
+            /* Read the 3 fields, count the new ones and sort them */
             rslt = read_all_field_data(field_ptr, dev);
 
             new_fields = 0;
-            for (i = 0; (i < 3) && (rslt == BME68X_OK); i++)
-            {
-                if (field_ptr[i]->status & BME68X_NEW_DATA_MSK)
-                {
-                    new_fields++;
-                }
-            }
-
-            /* Sort the sensor data in parallel & sequential modes*/
-            for (i = 0; (i < 2) && (rslt == BME68X_OK); i++)
-            {
-                for (j = i + 1; j < 3; j++)
-                {
-                    sort_sensor_data(i, j, field_ptr);
-                }
-            }
-
-            /* Copy the sorted data */
-            for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
+            if (rslt == BME68X_OK)
             {
-                data[i] = *field_ptr[i];
+                new_fields = collect_new_fields(field_ptr, data);
             }
 
             if (new_fields == 0)
@@ -624,6 +763,80 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
     return rslt;
 }
 
+/*
+ * @brief This API decodes and compensates a forced mode field read by the caller.
+ */
+int8_t bme68x_parse_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t *ctrl_meas;
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (buff != NULL) && (data != NULL))
+    {
+        parse_field_status(buff, data, dev);
+        if (data->status & BME68X_NEW_DATA_MSK)
+        {
+            rslt = get_heatr_meta(data, 0, dev);
+            if (rslt == BME68X_OK)
+            {
+                calc_field_data(buff, data, dev);
+
+                /* The sensor went back to sleep when the forced measurement completed */
+                ctrl_meas = &dev->shadow.ctrl[BME68X_REG_CTRL_MEAS - BME68X_REG_CTRL_GAS_0];
+                if ((*ctrl_meas & BME68X_MODE_MSK) == BME68X_FORCED_MODE)
+                {
+                    *ctrl_meas &= ~BME68X_MODE_MSK;
+                }
+            }
+        }
+        else
+        {
+            rslt = BME68X_W_NO_NEW_DATA;
+        }
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API decodes and compensates the three fields of a parallel or
+ * sequential mode read done by the caller.
+ */
+int8_t bme68x_parse_all_field_data(const uint8_t *buff, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t new_fields = 0;
+    struct bme68x_data field_data[3] = { { 0 } };
+    struct bme68x_data *field_ptr[3] = { &field_data[0], &field_data[1], &field_data[2] };
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (buff != NULL) && (data != NULL) && (n_data != NULL))
+    {
+        rslt = parse_all_field_data(buff, field_ptr, dev);
+        if (rslt == BME68X_OK)
+        {
+            new_fields = collect_new_fields(field_ptr, data);
+            if (new_fields == 0)
+            {
+                rslt = BME68X_W_NO_NEW_DATA;
+            }
+        }
+
+        *n_data = new_fields;
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API is used to set the gas configuration of the sensor.
  */
@@ -633,21 +846,36 @@ int8_t bme68x_set_heatr_conf(uint8_t op_mode, const struct bme68x_heatr_conf *co
     uint8_t nb_conv = 0;
     uint8_t hctrl, run_gas = 0;
     uint8_t ctrl_gas_data[2];
-    uint8_t ctrl_gas_addr[2] = { BME68X_REG_CTRL_GAS_0, BME68X_REG_CTRL_GAS_1 };
+    uint8_t reg_addr[BME68X_LEN_HEATR_WRITE] = { 0 };
+    uint8_t reg_data[BME68X_LEN_HEATR_WRITE] = { 0 };
+    uint8_t len = 0;
+    uint8_t n_xfers = 0;
+
+    /* Separate writes needed without the shadow: res_heat, gas_wait, CTRL_GAS
+     * and the shared heater duration in parallel mode */
+    uint8_t legacy_xfers = (op_mode == BME68X_PARALLEL_MODE) ? 4 : 3;
 
     if (conf != NULL)
     {
         rslt = bme68x_set_op_mode(BME68X_SLEEP_MODE, dev);
+        /* One read of the heater bank lets later configurations skip unchanged registers */
+        if ((rslt == BME68X_OK) && !(dev->shadow.valid & BME68X_SHADOW_HEATR))
+        {
+            rslt = shadow_fill(BME68X_SHADOW_HEATR, 0, dev);
+        }
+
         if (rslt == BME68X_OK)
         {
-            rslt = set_conf(conf, op_mode, &nb_conv, dev);
+            rslt = set_conf(conf, op_mode, &nb_conv, reg_addr, reg_data, &len, dev);
         }
 
         if (rslt == BME68X_OK)
         {
-            rslt = bme68x_get_regs(BME68X_REG_CTRL_GAS_0, ctrl_gas_data, 2, dev);
+            rslt = shadow_fill(BME68X_SHADOW_CTRL, 1, dev);
             if (rslt == BME68X_OK)
             {
+                ctrl_gas_data[0] = dev->shadow.ctrl[0];
+                ctrl_gas_data[1] = dev->shadow.ctrl[1];
                 if (conf->enable == BME68X_ENABLE)
                 {
                     hctrl = BME68X_ENABLE_HEATER;
@@ -669,7 +897,18 @@ int8_t bme68x_set_heatr_conf(uint8_t op_mode, const struct bme68x_heatr_conf *co
                 ctrl_gas_data[0] = BME68X_SET_BITS(ctrl_gas_data[0], BME68X_HCTRL, hctrl);
                 ctrl_gas_data[1] = BME68X_SET_BITS_POS_0(ctrl_gas_data[1], BME68X_NBCONV, nb_conv);
                 ctrl_gas_data[1] = BME68X_SET_BITS(ctrl_gas_data[1], BME68X_RUN_GAS, run_gas);
-                rslt = bme68x_set_regs(ctrl_gas_addr, ctrl_gas_data, 2, dev);
+
+                reg_addr[len] = BME68X_REG_CTRL_GAS_0;
+                reg_data[len++] = ctrl_gas_data[0];
+                reg_addr[len] = BME68X_REG_CTRL_GAS_1;
+                reg_data[len++] = ctrl_gas_data[1];
+
+                /* Heater and gas control registers go out in one burst */
+                rslt = shadow_write(reg_addr, reg_data, len, &n_xfers, dev);
+                if (legacy_xfers > n_xfers)
+                {
+                    dev->shadow.saved_xfers += (uint32_t)(legacy_xfers - n_xfers);
+                }
             }
         }
     }
@@ -730,7 +969,7 @@ int8_t bme68x_selftest_check(const struct bme68x_dev *dev)
     uint8_t n_fields;
     uint8_t i = 0;
     struct bme68x_data data[BME68X_N_MEAS] = { { 0 } };
-    struct bme68x_dev t_dev;
+    struct bme68x_dev t_dev = { 0 };
     struct bme68x_conf conf;
     struct bme68x_heatr_conf heatr_conf;
 
@@ -888,9 +1127,11 @@ static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
 
     var1 = ((int32_t)dev->calib.par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
     var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)dev->calib.par_p8) >> 13;
+
+    /* (p >> 8)^3 * par_p10 overflows int32 above ~1068 hPa, so drop 8 bits of the cube before scaling */
     var3 =
-        ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
-         (int32_t)dev->calib.par_p10) >> 17;
+        ((((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8)) >> 8) *
+         (int32_t)dev->calib.par_p10) >> 9;
     pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)dev->calib.par_p7 << 7)) >> 4);
 
     /*lint -restore */
@@ -944,22 +1185,12 @@ static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range,
     uint64_t var2;
     int64_t var3;
     uint32_t calc_gas_res;
-    uint32_t lookup_table1[16] = {
-        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
-        UINT32_C(2147483647)
-    };
-    uint32_t lookup_table2[16] = {
-        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
-        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
-            4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
-    };
 
     /*lint -save -e704 */
-    var1 = (int64_t)((1340 + (5 * (int64_t)dev->calib.range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
+    var1 = (int64_t)((1340 + (5 * (int64_t)dev->calib.range_sw_err)) *
+                     ((int64_t)bme68x_gas_low_table1[gas_range])) >> 16;
     var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
-    var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
+    var3 = (((int64_t)bme68x_gas_low_table2[gas_range] * (int64_t)var1) >> 9);
     calc_gas_res = (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
 
     /*lint -restore */
@@ -970,21 +1201,21 @@ static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range,
 static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
 {
     uint32_t calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
     int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
 
     var2 *= INT32_C(3);
     var2 = INT32_C(4096) + var2;
 
-    /* multiplying 10000 then dividing then multiplying by 100 instead of multiplying by 1000000 to prevent overflow */
-    calc_gas_res = (UINT32_C(10000) * var1) / (uint32_t)var2;
+    /* 10000 * (262144 >> gas_range) from the table, then dividing then multiplying by 100 instead of multiplying by
+     * 1000000 to prevent overflow */
+    calc_gas_res = bme68x_gas_high_num[gas_range] / (uint32_t)var2;
     calc_gas_res = calc_gas_res * 100;
 
     return calc_gas_res;
 }
 
 /* This internal API is used to calculate the heater resistance value using integer */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+static uint8_t calc_res_heat(uint16_t temp, int8_t amb_temp, const struct bme68x_dev *dev)
 {
     uint8_t heatr_res;
     int32_t var1;
@@ -999,7 +1230,7 @@ static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
         temp = 400;
     }
 
-    var1 = (((int32_t)dev->amb_temp * dev->calib.par_gh3) / 1000) * 256;
+    var1 = (((int32_t)amb_temp * dev->calib.par_gh3) / 1000) * 256;
     var2 = (dev->calib.par_gh1 + 784) * (((((dev->calib.par_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
     var3 = var1 + (var2 / 2);
     var4 = (var3 / (dev->calib.res_heat_range + 4));
@@ -1015,23 +1246,23 @@ static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
 /* @brief This internal API is used to calculate the temperature value. */
 static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
 {
+    const struct bme68x_calib_derived *d = &dev->calib.derived;
     float var1;
     float var2;
     float calc_temp;
 
     /* calculate var1 data */
-    var1 = ((((float)temp_adc / 16384.0f) - ((float)dev->calib.par_t1 / 1024.0f)) * ((float)dev->calib.par_t2));
+    var1 = (((float)temp_adc * (1.0f / 16384.0f)) - d->t1_1024) * ((float)dev->calib.par_t2);
 
     /* calculate var2 data */
-    var2 =
-        (((((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f)) *
-          (((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f))) * ((float)dev->calib.par_t3 * 16.0f));
+    var2 = ((float)temp_adc * (1.0f / 131072.0f)) - d->t1_8192;
+    var2 = var2 * var2 * d->t3_16;
 
     /* t_fine value*/
     dev->calib.t_fine = (var1 + var2);
 
     /* compensated temperature data*/
-    calc_temp = ((dev->calib.t_fine) / 5120.0f);
+    calc_temp = dev->calib.t_fine * (1.0f / 5120.0f);
 
     return calc_temp;
 }
@@ -1039,27 +1270,28 @@ static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
 /* @brief This internal API is used to calculate the pressure value. */
 static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
 {
+    const struct bme68x_calib_derived *d = &dev->calib.derived;
     float var1;
     float var2;
     float var3;
     float calc_pres;
 
-    var1 = (((float)dev->calib.t_fine / 2.0f) - 64000.0f);
-    var2 = var1 * var1 * (((float)dev->calib.par_p6) / (131072.0f));
-    var2 = var2 + (var1 * ((float)dev->calib.par_p5) * 2.0f);
-    var2 = (var2 / 4.0f) + (((float)dev->calib.par_p4) * 65536.0f);
-    var1 = (((((float)dev->calib.par_p3 * var1 * var1) / 16384.0f) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
-    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)dev->calib.par_p1));
+    var1 = (dev->calib.t_fine * 0.5f) - 64000.0f;
+    var2 = var1 * ((var1 * d->p6_s) + d->p5_s);
+    var2 = (var2 * 0.25f) + d->p4_s;
+    var1 = var1 * ((d->p3_s * var1) + d->p2_s);
+    var1 = (float)dev->calib.par_p1 + (var1 * d->p1_32768);
     calc_pres = (1048576.0f - ((float)pres_adc));
 
     /* Avoid exception caused by division by zero */
     if ((int)var1 != 0)
     {
-        calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
-        var1 = (((float)dev->calib.par_p9) * calc_pres * calc_pres) / 2147483648.0f;
-        var2 = calc_pres * (((float)dev->calib.par_p8) / 32768.0f);
-        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (dev->calib.par_p10 / 131072.0f));
-        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)dev->calib.par_p7 * 128.0f)) / 16.0f);
+        /* The only division left, var1 depends on the temperature */
+        calc_pres = ((calc_pres - (var2 * (1.0f / 4096.0f))) * 6250.0f) / var1;
+        var1 = d->p9_s * calc_pres * calc_pres;
+        var2 = calc_pres * d->p8_s;
+        var3 = calc_pres * calc_pres * calc_pres * d->p10_s;
+        calc_pres = calc_pres + ((var1 + var2 + var3 + d->p7_s) * (1.0f / 16.0f));
     }
     else
     {
@@ -1072,24 +1304,17 @@ static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
 /* This internal API is used to calculate the humidity in integer */
 static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
 {
+    const struct bme68x_calib_derived *d = &dev->calib.derived;
     float calc_hum;
     float var1;
     float var2;
-    float var3;
-    float var4;
     float temp_comp;
 
     /* compensated temperature data*/
-    temp_comp = ((dev->calib.t_fine) / 5120.0f);
-    var1 = (float)((float)hum_adc) -
-           (((float)dev->calib.par_h1 * 16.0f) + (((float)dev->calib.par_h3 / 2.0f) * temp_comp));
-    var2 = var1 *
-           ((float)(((float)dev->calib.par_h2 / 262144.0f) *
-                    (1.0f + (((float)dev->calib.par_h4 / 16384.0f) * temp_comp) +
-                     (((float)dev->calib.par_h5 / 1048576.0f) * temp_comp * temp_comp))));
-    var3 = (float)dev->calib.par_h6 / 16384.0f;
-    var4 = (float)dev->calib.par_h7 / 2097152.0f;
-    calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
+    temp_comp = dev->calib.t_fine * (1.0f / 5120.0f);
+    var1 = (float)hum_adc - (d->h1_s + (d->h3_s * temp_comp));
+    var2 = var1 * d->h2_s * (1.0f + (temp_comp * (d->h4_s + (d->h5_s * temp_comp))));
+    calc_hum = var2 + ((d->h6_s + (d->h7_s * temp_comp)) * var2 * var2);
     if (calc_hum > 100.0f)
     {
         calc_hum = 100.0f;
@@ -1105,23 +1330,13 @@ static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
 /* This internal API is used to calculate the gas resistance low value in float */
 static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
 {
+    const struct bme68x_calib_derived *d = &dev->calib.derived;
     float calc_gas_res;
-    float var1;
-    float var2;
-    float var3;
-    float gas_res_f = gas_res_adc;
-    float gas_range_f = (1U << gas_range); /*lint !e790 / Suspicious truncation, integral to float */
-    const float lookup_k1_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
-    };
-    const float lookup_k2_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
-    };
-
-    var1 = (1340.0f + (5.0f * dev->calib.range_sw_err));
-    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
-    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
-    calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
+
+    /* The resistance is inversely proportional to the ADC value, so one division stays */
+    calc_gas_res = 1.0f /
+                   (bme68x_gas_low_scale[gas_range] *
+                    ((((float)gas_res_adc - 512.0f) * bme68x_gas_low_k1_inv[gas_range] * d->gas_inv_sw_err) + 1.0f));
 
     return calc_gas_res;
 }
@@ -1130,19 +1345,51 @@ static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, co
 static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
 {
     float calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
     int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
 
     var2 *= INT32_C(3);
     var2 = INT32_C(4096) + var2;
 
-    calc_gas_res = 1000000.0f * (float)var1 / (float)var2;
+    /* 1000000 * (262144 >> gas_range) comes from the table */
+    calc_gas_res = bme68x_gas_high_num[gas_range] / (float)var2;
 
     return calc_gas_res;
 }
 
+/* This internal API is used to derive the float compensation terms from the calibration coefficients */
+static void calc_derived_calib(struct bme68x_calib_data *calib)
+{
+    struct bme68x_calib_derived *d = &calib->derived;
+
+    d->t1_1024 = (float)calib->par_t1 / 1024.0f;
+    d->t1_8192 = (float)calib->par_t1 / 8192.0f;
+    d->t3_16 = (float)calib->par_t3 * 16.0f;
+
+    d->p1_32768 = (float)calib->par_p1 / 32768.0f;
+    d->p2_s = (float)calib->par_p2 / 524288.0f;
+    d->p3_s = (float)calib->par_p3 / 16384.0f / 524288.0f;
+    d->p4_s = (float)calib->par_p4 * 65536.0f;
+    d->p5_s = (float)calib->par_p5 * 2.0f;
+    d->p6_s = (float)calib->par_p6 / 131072.0f;
+    d->p7_s = (float)calib->par_p7 * 128.0f;
+    d->p8_s = (float)calib->par_p8 / 32768.0f;
+    d->p9_s = (float)calib->par_p9 / 2147483648.0f;
+    d->p10_s = (float)calib->par_p10 / 16777216.0f / 131072.0f;
+
+    d->h1_s = (float)calib->par_h1 * 16.0f;
+    d->h2_s = (float)calib->par_h2 / 262144.0f;
+    d->h3_s = (float)calib->par_h3 / 2.0f;
+    d->h4_s = (float)calib->par_h4 / 16384.0f;
+    d->h5_s = (float)calib->par_h5 / 1048576.0f;
+    d->h6_s = (float)calib->par_h6 / 16384.0f;
+    d->h7_s = (float)calib->par_h7 / 2097152.0f;
+
+    /* Gas low variant, the per-range terms are in bme68x_tables.h */
+    d->gas_inv_sw_err = 1.0f / (1340.0f + (5.0f * calib->range_sw_err));
+}
+
 /* This internal API is used to calculate the heater resistance value using float */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+static uint8_t calc_res_heat(uint16_t temp, int8_t amb_temp, const struct bme68x_dev *dev)
 {
     float var1;
     float var2;
@@ -1160,7 +1407,7 @@ static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
     var2 = ((((float)dev->calib.par_gh2 / (32768.0f)) * (0.0005f)) + 0.00235f);
     var3 = ((float)dev->calib.par_gh3 / (1024.0f));
     var4 = (var1 * (1.0f + (var2 * (float)temp)));
-    var5 = (var4 + (var3 * (float)dev->amb_temp));
+    var5 = (var4 + (var3 * (float)amb_temp));
     res_heat =
         (uint8_t)(3.4f *
                   ((var5 * (4 / (4 + (float)dev->calib.res_heat_range)) *
@@ -1196,20 +1443,54 @@ static uint8_t calc_gas_wait(uint16_t dur)
     return durval;
 }
 
+/* This internal API is used to get the heater resistance from the cache, calculating it on a miss */
+static uint8_t get_res_heat(uint16_t temp, struct bme68x_dev *dev)
+{
+    struct bme68x_heatr_cache *cache = &dev->heatr_cache;
+    struct bme68x_heatr_cache_entry *entry;
+    int8_t amb_bucket;
+    uint8_t i;
+
+    if (temp > 400) /* Cap temperature */
+    {
+        temp = 400;
+    }
+
+    /* Round down, also for negative ambient temperatures */
+    amb_bucket = (int8_t)((dev->amb_temp - ((dev->amb_temp < 0) ? (BME68X_AMB_BUCKET_WIDTH - 1) : 0)) /
+                          BME68X_AMB_BUCKET_WIDTH);
+
+    for (i = 0; i < BME68X_HEATR_CACHE_LEN; i++)
+    {
+        entry = &cache->entry[i];
+        if (entry->valid && (entry->temp == temp) && (entry->amb_bucket == amb_bucket))
+        {
+            return entry->res_heat;
+        }
+    }
+
+    /* Calculate for the middle of the bucket, so the value does not depend on where in the bucket it was filled */
+    entry = &cache->entry[cache->next];
+    cache->next = (uint8_t)((cache->next + 1) % BME68X_HEATR_CACHE_LEN);
+    entry->temp = temp;
+    entry->amb_bucket = amb_bucket;
+    entry->res_heat =
+        calc_res_heat(temp, (int8_t)((amb_bucket * BME68X_AMB_BUCKET_WIDTH) + (BME68X_AMB_BUCKET_WIDTH / 2)), dev);
+    entry->valid = 1;
+
+    return entry->res_heat;
+}
+
 /* This internal API is used to read a single data of the sensor */
 static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bme68x_dev *dev)
 {
     int8_t rslt = BME68X_OK;
     uint8_t buff[BME68X_LEN_FIELD] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
-    uint32_t adc_temp;
-    uint32_t adc_pres;
-    uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
     uint8_t tries = 5;
 
     while ((tries) && (rslt == BME68X_OK))
     {
+        /* The whole field is fetched in one burst, heater data comes from the shadow */
         rslt = bme68x_get_regs(((uint8_t)(BME68X_REG_FIELD0 + (index * BME68X_LEN_FIELD_OFFSET))),
                                buff,
                                (uint16_t)BME68X_LEN_FIELD,
@@ -1220,55 +1501,16 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
             break;
         }
 
-        data->status = buff[0] & BME68X_NEW_DATA_MSK;
-        data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
-        data->meas_index = buff[1];
-
-        /* read the raw data from the sensor */
-        adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
-        adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
-        adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
-        adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
-        adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
-        gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data->status |= buff[16] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
-        }
-        else
-        {
-            data->status |= buff[14] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
-        }
+        parse_field_status(buff, data, dev);
 
         if ((data->status & BME68X_NEW_DATA_MSK) && (rslt == BME68X_OK))
         {
-            rslt = bme68x_get_regs(BME68X_REG_RES_HEAT0 + data->gas_index, &data->res_heat, 1, dev);
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0 + data->gas_index, &data->idac, 1, dev);
-            }
-
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_get_regs(BME68X_REG_GAS_WAIT0 + data->gas_index, &data->gas_wait, 1, dev);
-            }
+            /* Stock driver reads res_heat, idac and gas_wait one register at a time */
+            rslt = get_heatr_meta(data, 3, dev);
 
             if (rslt == BME68X_OK)
             {
-                data->temperature = calc_temperature(adc_temp, dev);
-                data->pressure = calc_pressure(adc_pres, dev);
-                data->humidity = calc_humidity(adc_hum, dev);
-                if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-                {
-                    data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
-                }
-                else
-                {
-                    data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
-                }
+                calc_field_data(buff, data, dev);
 
                 break;
             }
@@ -1290,14 +1532,6 @@ static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme6
 {
     int8_t rslt = BME68X_OK;
     uint8_t buff[BME68X_LEN_FIELD * 3] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
-    uint32_t adc_temp;
-    uint32_t adc_pres;
-    uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
-    uint8_t off;
-    uint8_t set_val[30] = { 0 }; /* idac, res_heat, gas_wait */
-    uint8_t i;
 
     if (!data[0] && !data[1] && !data[2])
     {
@@ -1311,52 +1545,144 @@ static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme6
 
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, set_val, 30, dev);
+        rslt = parse_all_field_data(buff, data, dev);
     }
 
+    return rslt;
+}
+
+/* This internal API is used to decode and compensate the three fields of a parallel or sequential mode read */
+static int8_t parse_all_field_data(const uint8_t *buff, struct bme68x_data * const data[], struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+    uint8_t off;
+    uint8_t i;
+
     for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
     {
         off = (uint8_t)(i * BME68X_LEN_FIELD);
-        data[i]->status = buff[off] & BME68X_NEW_DATA_MSK;
-        data[i]->gas_index = buff[off] & BME68X_GAS_INDEX_MSK;
-        data[i]->meas_index = buff[off + 1];
-
-        /* read the raw data from the sensor */
-        adc_pres =
-            (uint32_t) (((uint32_t) buff[off + 2] * 4096) | ((uint32_t) buff[off + 3] * 16) |
-                        ((uint32_t) buff[off + 4] / 16));
-        adc_temp =
-            (uint32_t) (((uint32_t) buff[off + 5] * 4096) | ((uint32_t) buff[off + 6] * 16) |
-                        ((uint32_t) buff[off + 7] / 16));
-        adc_hum = (uint16_t) (((uint32_t) buff[off + 8] * 256) | (uint32_t) buff[off + 9]);
-        adc_gas_res_low = (uint16_t) ((uint32_t) buff[off + 13] * 4 | (((uint32_t) buff[off + 14]) / 64));
-        adc_gas_res_high = (uint16_t) ((uint32_t) buff[off + 15] * 4 | (((uint32_t) buff[off + 16]) / 64));
-        gas_range_l = buff[off + 14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[off + 16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data[i]->status |= buff[off + 16] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 16] & BME68X_HEAT_STAB_MSK;
+        parse_field_status(&buff[off], data[i], dev);
+
+        /* Stock driver reads the 30 heater registers once for all fields */
+        rslt = get_heatr_meta(data[i], (i == 0) ? 1 : 0, dev);
+        if (rslt == BME68X_OK)
+        {
+            calc_field_data(&buff[off], data[i], dev);
         }
-        else
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to count the new fields and copy them sorted by measurement index */
+static uint8_t collect_new_fields(struct bme68x_data *field[], struct bme68x_data *data)
+{
+    uint8_t new_fields = 0;
+    uint8_t i, j;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (field[i]->status & BME68X_NEW_DATA_MSK)
         {
-            data[i]->status |= buff[off + 14] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 14] & BME68X_HEAT_STAB_MSK;
+            new_fields++;
         }
+    }
 
-        data[i]->idac = set_val[data[i]->gas_index];
-        data[i]->res_heat = set_val[10 + data[i]->gas_index];
-        data[i]->gas_wait = set_val[20 + data[i]->gas_index];
-        data[i]->temperature = calc_temperature(adc_temp, dev);
-        data[i]->pressure = calc_pressure(adc_pres, dev);
-        data[i]->humidity = calc_humidity(adc_hum, dev);
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    /* Sort the sensor data in parallel & sequential modes*/
+    for (i = 0; i < 2; i++)
+    {
+        for (j = i + 1; j < 3; j++)
         {
-            data[i]->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+            sort_sensor_data(i, j, field);
         }
-        else
+    }
+
+    /* Copy the sorted data */
+    for (i = 0; i < 3; i++)
+    {
+        data[i] = *field[i];
+    }
+
+    return new_fields;
+}
+
+/* This internal API is used to decode the status byte and indexes of a field */
+static void parse_field_status(const uint8_t *buff, struct bme68x_data *data, const struct bme68x_dev *dev)
+{
+    data->status = buff[0] & BME68X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        data->status |= buff[16] & BME68X_GASM_VALID_MSK;
+        data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
+    }
+    else
+    {
+        data->status |= buff[14] & BME68X_GASM_VALID_MSK;
+        data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
+    }
+}
+
+/* This internal API is used to compensate the raw data of a field */
+static void calc_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev)
+{
+    uint8_t gas_range_l, gas_range_h;
+    uint32_t adc_temp;
+    uint32_t adc_pres;
+    uint16_t adc_hum;
+    uint16_t adc_gas_res_low, adc_gas_res_high;
+
+    /* read the raw data from the sensor */
+    adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
+    adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
+    adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
+    adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
+    adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
+    gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
+    gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
+
+    data->temperature = calc_temperature(adc_temp, dev);
+    data->pressure = calc_pressure(adc_pres, dev);
+    data->humidity = calc_humidity(adc_hum, dev);
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+    }
+    else
+    {
+        data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+    }
+}
+
+/* This internal API is used to get res_heat, idac and gas_wait of the heater step used by a field */
+static int8_t get_heatr_meta(struct bme68x_data *data, uint8_t legacy_xfers, struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+    uint8_t gas_index = data->gas_index;
+
+    if (gas_index >= BME68X_MAX_PROFILE_LEN)
+    {
+        gas_index = 0;
+    }
+
+    if (dev->skip_heatr_meta)
+    {
+        /* Caller does not use the heater data, leave the bus alone */
+        data->idac = 0;
+        data->res_heat = 0;
+        data->gas_wait = 0;
+        dev->shadow.saved_xfers += legacy_xfers;
+    }
+    else
+    {
+        /* The heater registers are only written by the driver, the shadow has them */
+        rslt = shadow_fill(BME68X_SHADOW_HEATR, legacy_xfers, dev);
+        if (rslt == BME68X_OK)
         {
-            data[i]->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+            data->idac = dev->shadow.heatr[gas_index];
+            data->res_heat = dev->shadow.heatr[BME68X_REG_RES_HEAT0 - BME68X_REG_IDAC_HEAT0 + gas_index];
+            data->gas_wait = dev->shadow.heatr[BME68X_REG_GAS_WAIT0 - BME68X_REG_IDAC_HEAT0 + gas_index];
         }
     }
 
@@ -1470,28 +1796,28 @@ static int8_t null_ptr_check(const struct bme68x_dev *dev)
     return rslt;
 }
 
-/* This internal API is used to set heater configurations */
-static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, uint8_t *nb_conv, struct bme68x_dev *dev)
+/* This internal API is used to build the heater configuration registers */
+static int8_t set_conf(const struct bme68x_heatr_conf *conf,
+                       uint8_t op_mode,
+                       uint8_t *nb_conv,
+                       uint8_t *reg_addr,
+                       uint8_t *reg_data,
+                       uint8_t *len,
+                       struct bme68x_dev *dev)
 {
     int8_t rslt = BME68X_OK;
     uint8_t i;
-    uint8_t shared_dur;
     uint8_t write_len = 0;
-    uint8_t heater_dur_shared_addr = BME68X_REG_SHD_HEATR_DUR;
-    uint8_t rh_reg_addr[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t rh_reg_data[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t gw_reg_addr[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t gw_reg_data[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
     switch (op_mode)
     {
         case BME68X_FORCED_MODE:
-            rh_reg_addr[0] = BME68X_REG_RES_HEAT0;
-            rh_reg_data[0] = calc_res_heat(conf->heatr_temp, dev);
-            gw_reg_addr[0] = BME68X_REG_GAS_WAIT0;
-            gw_reg_data[0] = calc_gas_wait(conf->heatr_dur);
+            reg_addr[0] = BME68X_REG_RES_HEAT0;
+            reg_data[0] = get_res_heat(conf->heatr_temp, dev);
+            reg_addr[1] = BME68X_REG_GAS_WAIT0;
+            reg_data[1] = calc_gas_wait(conf->heatr_dur);
             (*nb_conv) = 0;
-            write_len = 1;
+            write_len = 2;
             break;
         case BME68X_SEQUENTIAL_MODE:
             if ((!conf->heatr_dur_prof) || (!conf->heatr_temp_prof))
@@ -1500,16 +1826,22 @@ static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, ui
                 break;
             }
 
+            if (conf->profile_len > BME68X_MAX_PROFILE_LEN)
+            {
+                rslt = BME68X_E_INVALID_LENGTH;
+                break;
+            }
+
             for (i = 0; i < conf->profile_len; i++)
             {
-                rh_reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
-                rh_reg_data[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
-                gw_reg_addr[i] = BME68X_REG_GAS_WAIT0 + i;
-                gw_reg_data[i] = calc_gas_wait(conf->heatr_dur_prof[i]);
+                reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
+                reg_data[i] = get_res_heat(conf->heatr_temp_prof[i], dev);
+                reg_addr[conf->profile_len + i] = BME68X_REG_GAS_WAIT0 + i;
+                reg_data[conf->profile_len + i] = calc_gas_wait(conf->heatr_dur_prof[i]);
             }
 
             (*nb_conv) = conf->profile_len;
-            write_len = conf->profile_len;
+            write_len = (uint8_t)(2 * conf->profile_len);
             break;
         case BME68X_PARALLEL_MODE:
             if ((!conf->heatr_dur_prof) || (!conf->heatr_temp_prof))
@@ -1518,6 +1850,12 @@ static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, ui
                 break;
             }
 
+            if (conf->profile_len > BME68X_MAX_PROFILE_LEN)
+            {
+                rslt = BME68X_E_INVALID_LENGTH;
+                break;
+            }
+
             if (conf->shared_heatr_dur == 0)
             {
                 rslt = BME68X_W_DEFINE_SHD_HEATR_DUR;
@@ -1525,33 +1863,160 @@ static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, ui
 
             for (i = 0; i < conf->profile_len; i++)
             {
-                rh_reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
-                rh_reg_data[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
-                gw_reg_addr[i] = BME68X_REG_GAS_WAIT0 + i;
-                gw_reg_data[i] = (uint8_t) conf->heatr_dur_prof[i];
+                reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
+                reg_data[i] = get_res_heat(conf->heatr_temp_prof[i], dev);
+                reg_addr[conf->profile_len + i] = BME68X_REG_GAS_WAIT0 + i;
+                reg_data[conf->profile_len + i] = (uint8_t) conf->heatr_dur_prof[i];
             }
 
             (*nb_conv) = conf->profile_len;
-            write_len = conf->profile_len;
-            shared_dur = calc_heatr_dur_shared(conf->shared_heatr_dur);
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_set_regs(&heater_dur_shared_addr, &shared_dur, 1, dev);
-            }
-
+            write_len = (uint8_t)(2 * conf->profile_len);
+            reg_addr[write_len] = BME68X_REG_SHD_HEATR_DUR;
+            reg_data[write_len++] = calc_heatr_dur_shared(conf->shared_heatr_dur);
             break;
         default:
             rslt = BME68X_W_DEFINE_OP_MODE;
     }
 
+    *len = write_len;
+
+    return rslt;
+}
+
+/* This internal API is used to load a register bank into the shadow */
+static int8_t shadow_fill(uint8_t bank, uint8_t legacy_xfers, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    rslt = null_ptr_check(dev);
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_set_regs(rh_reg_addr, rh_reg_data, write_len, dev);
+        if (dev->shadow.valid & bank)
+        {
+            /* The reads this call stands in for are not needed */
+            dev->shadow.saved_xfers += legacy_xfers;
+        }
+        else if (bank == BME68X_SHADOW_CTRL)
+        {
+            rslt = bme68x_get_regs(BME68X_REG_CTRL_GAS_0, dev->shadow.ctrl, BME68X_LEN_SHADOW_CTRL, dev);
+        }
+        else
+        {
+            rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, dev->shadow.heatr, BME68X_LEN_SHADOW_HEATR, dev);
+        }
+
+        if (rslt == BME68X_OK)
+        {
+            dev->shadow.valid |= bank;
+        }
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to update the shadow after a register write */
+static void shadow_update(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if ((reg_addr[i] >= BME68X_REG_CTRL_GAS_0) && (reg_addr[i] < (BME68X_REG_CTRL_GAS_0 + BME68X_LEN_SHADOW_CTRL)))
+        {
+            dev->shadow.ctrl[reg_addr[i] - BME68X_REG_CTRL_GAS_0] = reg_data[i];
+        }
+        else if ((reg_addr[i] >= BME68X_REG_IDAC_HEAT0) &&
+                 (reg_addr[i] < (BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW_HEATR)))
+        {
+            dev->shadow.heatr[reg_addr[i] - BME68X_REG_IDAC_HEAT0] = reg_data[i];
+        }
+    }
+}
+
+/* This internal API is used to write only the registers that differ from the shadow */
+static int8_t shadow_write(const uint8_t *reg_addr,
+                           const uint8_t *reg_data,
+                           uint8_t len,
+                           uint8_t *n_xfers,
+                           struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+    uint8_t addr[BME68X_LEN_HEATR_WRITE];
+    uint8_t data[BME68X_LEN_HEATR_WRITE];
+    uint8_t i, n = 0, off, chunk;
+    uint8_t known;
+
+    *n_xfers = 0;
+    if (len > BME68X_LEN_HEATR_WRITE)
+    {
+        return BME68X_E_INVALID_LENGTH;
     }
 
+    /* Drop the registers already holding the wanted value */
+    for (i = 0; i < len; i++)
+    {
+        known = 0;
+        if ((dev->shadow.valid & BME68X_SHADOW_CTRL) && (reg_addr[i] >= BME68X_REG_CTRL_GAS_0) &&
+            (reg_addr[i] < (BME68X_REG_CTRL_GAS_0 + BME68X_LEN_SHADOW_CTRL)))
+        {
+            known = (dev->shadow.ctrl[reg_addr[i] - BME68X_REG_CTRL_GAS_0] == reg_data[i]);
+        }
+        else if ((dev->shadow.valid & BME68X_SHADOW_HEATR) && (reg_addr[i] >= BME68X_REG_IDAC_HEAT0) &&
+                 (reg_addr[i] < (BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW_HEATR)))
+        {
+            known = (dev->shadow.heatr[reg_addr[i] - BME68X_REG_IDAC_HEAT0] == reg_data[i]);
+        }
+
+        if (!known)
+        {
+            addr[n] = reg_addr[i];
+            data[n] = reg_data[i];
+            n++;
+        }
+    }
+
+    /* Write the rest in as few bursts as the interleave buffer allows */
+    for (off = 0; (off < n) && (rslt == BME68X_OK); off += chunk)
+    {
+        chunk = (uint8_t)(n - off);
+        if (chunk > (BME68X_LEN_INTERLEAVE_BUFF / 2))
+        {
+            chunk = BME68X_LEN_INTERLEAVE_BUFF / 2;
+        }
+
+        rslt = bme68x_set_regs(&addr[off], &data[off], chunk, dev);
+        (*n_xfers)++;
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to read CTRL_MEAS, from the shadow when its content is known */
+static int8_t get_ctrl_meas(uint8_t *ctrl_meas, uint8_t use_shadow, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t *shadow_reg;
+
+    rslt = null_ptr_check(dev);
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_set_regs(gw_reg_addr, gw_reg_data, write_len, dev);
+        shadow_reg = &dev->shadow.ctrl[BME68X_REG_CTRL_MEAS - BME68X_REG_CTRL_GAS_0];
+
+        /* Only a forced measurement changes the mode behind the driver's back */
+        if (use_shadow && (dev->shadow.valid & BME68X_SHADOW_CTRL) &&
+            ((*shadow_reg & BME68X_MODE_MSK) != BME68X_FORCED_MODE))
+        {
+            *ctrl_meas = *shadow_reg;
+            dev->shadow.saved_xfers++;
+        }
+        else
+        {
+            rslt = bme68x_get_regs(BME68X_REG_CTRL_MEAS, ctrl_meas, 1, dev);
+            if (rslt == BME68X_OK)
+            {
+                *shadow_reg = *ctrl_meas;
+            }
+        }
     }
 
     return rslt;
@@ -1765,78 +2230,62 @@ static int8_t analyze_sensor_data(const struct bme68x_data *data, uint8_t n_meas
     return rslt;
 }
 
-/* This internal API is used to read the calibration coefficients */
-static int8_t get_calib_data(struct bme68x_dev *dev)
+/* This internal API is used to decode the calibration coefficients */
+static void parse_calib_data(const uint8_t *coeff_array, struct bme68x_dev *dev)
 {
-    int8_t rslt;
-    uint8_t coeff_array[BME68X_LEN_COEFF_ALL];
-
-    rslt = bme68x_get_regs(BME68X_REG_COEFF1, coeff_array, BME68X_LEN_COEFF1, dev);
-    if (rslt == BME68X_OK)
-    {
-        rslt = bme68x_get_regs(BME68X_REG_COEFF2, &coeff_array[BME68X_LEN_COEFF1], BME68X_LEN_COEFF2, dev);
-    }
-
-    if (rslt == BME68X_OK)
-    {
-        rslt = bme68x_get_regs(BME68X_REG_COEFF3,
-                               &coeff_array[BME68X_LEN_COEFF1 + BME68X_LEN_COEFF2],
-                               BME68X_LEN_COEFF3,
-                               dev);
-    }
-
-    if (rslt == BME68X_OK)
-    {
-        /* Temperature related coefficients */
-        dev->calib.par_t1 =
-            (uint16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_T1_MSB], coeff_array[BME68X_IDX_T1_LSB]));
-        dev->calib.par_t2 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_T2_MSB], coeff_array[BME68X_IDX_T2_LSB]));
-        dev->calib.par_t3 = (int8_t)(coeff_array[BME68X_IDX_T3]);
-
-        /* Pressure related coefficients */
-        dev->calib.par_p1 =
-            (uint16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P1_MSB], coeff_array[BME68X_IDX_P1_LSB]));
-        dev->calib.par_p2 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P2_MSB], coeff_array[BME68X_IDX_P2_LSB]));
-        dev->calib.par_p3 = (int8_t)coeff_array[BME68X_IDX_P3];
-        dev->calib.par_p4 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P4_MSB], coeff_array[BME68X_IDX_P4_LSB]));
-        dev->calib.par_p5 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P5_MSB], coeff_array[BME68X_IDX_P5_LSB]));
-        dev->calib.par_p6 = (int8_t)(coeff_array[BME68X_IDX_P6]);
-        dev->calib.par_p7 = (int8_t)(coeff_array[BME68X_IDX_P7]);
-        dev->calib.par_p8 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P8_MSB], coeff_array[BME68X_IDX_P8_LSB]));
-        dev->calib.par_p9 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P9_MSB], coeff_array[BME68X_IDX_P9_LSB]));
-        dev->calib.par_p10 = (uint8_t)(coeff_array[BME68X_IDX_P10]);
-
-        /* Humidity related coefficients */
-        dev->calib.par_h1 =
-            (uint16_t)(((uint16_t)coeff_array[BME68X_IDX_H1_MSB] << 4) |
-                       (coeff_array[BME68X_IDX_H1_LSB] & BME68X_BIT_H1_DATA_MSK));
-        dev->calib.par_h2 =
-            (uint16_t)(((uint16_t)coeff_array[BME68X_IDX_H2_MSB] << 4) | ((coeff_array[BME68X_IDX_H2_LSB]) >> 4));
-        dev->calib.par_h3 = (int8_t)coeff_array[BME68X_IDX_H3];
-        dev->calib.par_h4 = (int8_t)coeff_array[BME68X_IDX_H4];
-        dev->calib.par_h5 = (int8_t)coeff_array[BME68X_IDX_H5];
-        dev->calib.par_h6 = (uint8_t)coeff_array[BME68X_IDX_H6];
-        dev->calib.par_h7 = (int8_t)coeff_array[BME68X_IDX_H7];
-
-        /* Gas heater related coefficients */
-        dev->calib.par_gh1 = (int8_t)coeff_array[BME68X_IDX_GH1];
-        dev->calib.par_gh2 =
-            (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_GH2_MSB], coeff_array[BME68X_IDX_GH2_LSB]));
-        dev->calib.par_gh3 = (int8_t)coeff_array[BME68X_IDX_GH3];
-
-        /* Other coefficients */
-        dev->calib.res_heat_range = ((coeff_array[BME68X_IDX_RES_HEAT_RANGE] & BME68X_RHRANGE_MSK) / 16);
-        dev->calib.res_heat_val = (int8_t)coeff_array[BME68X_IDX_RES_HEAT_VAL];
-        dev->calib.range_sw_err = ((int8_t)(coeff_array[BME68X_IDX_RANGE_SW_ERR] & BME68X_RSERROR_MSK)) / 16;
-    }
+    /* Temperature related coefficients */
+    dev->calib.par_t1 =
+        (uint16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_T1_MSB], coeff_array[BME68X_IDX_T1_LSB]));
+    dev->calib.par_t2 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_T2_MSB], coeff_array[BME68X_IDX_T2_LSB]));
+    dev->calib.par_t3 = (int8_t)(coeff_array[BME68X_IDX_T3]);
+
+    /* Pressure related coefficients */
+    dev->calib.par_p1 =
+        (uint16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P1_MSB], coeff_array[BME68X_IDX_P1_LSB]));
+    dev->calib.par_p2 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P2_MSB], coeff_array[BME68X_IDX_P2_LSB]));
+    dev->calib.par_p3 = (int8_t)coeff_array[BME68X_IDX_P3];
+    dev->calib.par_p4 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P4_MSB], coeff_array[BME68X_IDX_P4_LSB]));
+    dev->calib.par_p5 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P5_MSB], coeff_array[BME68X_IDX_P5_LSB]));
+    dev->calib.par_p6 = (int8_t)(coeff_array[BME68X_IDX_P6]);
+    dev->calib.par_p7 = (int8_t)(coeff_array[BME68X_IDX_P7]);
+    dev->calib.par_p8 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P8_MSB], coeff_array[BME68X_IDX_P8_LSB]));
+    dev->calib.par_p9 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_P9_MSB], coeff_array[BME68X_IDX_P9_LSB]));
+    dev->calib.par_p10 = (uint8_t)(coeff_array[BME68X_IDX_P10]);
+
+    /* Humidity related coefficients */
+    dev->calib.par_h1 =
+        (uint16_t)(((uint16_t)coeff_array[BME68X_IDX_H1_MSB] << 4) |
+                   (coeff_array[BME68X_IDX_H1_LSB] & BME68X_BIT_H1_DATA_MSK));
+    dev->calib.par_h2 =
+        (uint16_t)(((uint16_t)coeff_array[BME68X_IDX_H2_MSB] << 4) | ((coeff_array[BME68X_IDX_H2_LSB]) >> 4));
+    dev->calib.par_h3 = (int8_t)coeff_array[BME68X_IDX_H3];
+    dev->calib.par_h4 = (int8_t)coeff_array[BME68X_IDX_H4];
+    dev->calib.par_h5 = (int8_t)coeff_array[BME68X_IDX_H5];
+    dev->calib.par_h6 = (uint8_t)coeff_array[BME68X_IDX_H6];
+    dev->calib.par_h7 = (int8_t)coeff_array[BME68X_IDX_H7];
+
+    /* Gas heater related coefficients */
+    dev->calib.par_gh1 = (int8_t)coeff_array[BME68X_IDX_GH1];
+    dev->calib.par_gh2 =
+        (int16_t)(BME68X_CONCAT_BYTES(coeff_array[BME68X_IDX_GH2_MSB], coeff_array[BME68X_IDX_GH2_LSB]));
+    dev->calib.par_gh3 = (int8_t)coeff_array[BME68X_IDX_GH3];
+
+    /* Other coefficients */
+    dev->calib.res_heat_range = ((coeff_array[BME68X_IDX_RES_HEAT_RANGE] & BME68X_RHRANGE_MSK) / 16);
+    dev->calib.res_heat_val = (int8_t)coeff_array[BME68X_IDX_RES_HEAT_VAL];
+    dev->calib.range_sw_err = ((int8_t)(coeff_array[BME68X_IDX_RANGE_SW_ERR] & BME68X_RSERROR_MSK)) / 16;
+#ifdef BME68X_USE_FPU
+    calc_derived_calib(&dev->calib);
+#endif
 
-    return rslt;
+    /* Cached heater values belong to the previous coefficients */
+    memset(&dev->heatr_cache, 0, sizeof(dev->heatr_cache));
 }
 
 /* This internal API is used to read variant ID information from the register */
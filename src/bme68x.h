@@ -76,6 +76,59 @@ extern "C" {
  */
 int8_t bme68x_init(struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiInit
+ * \page bme68x_api_bme68x_probe bme68x_probe
+ * \code
+ * int8_t bme68x_probe(struct bme68x_dev *dev);
+ * \endcode
+ * @details This API resets the sensor and reads its chip-id and variant-id.
+ * It is the part of bme68x_init() that runs before the calibration data is
+ * read, for callers that load the calibration with bme68x_set_calib_raw().
+ *
+ * @param[in,out] dev : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_probe(struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiInit
+ * \page bme68x_api_bme68x_get_calib_raw bme68x_get_calib_raw
+ * \code
+ * int8_t bme68x_get_calib_raw(uint8_t *coeff_array, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API reads the raw calibration coefficients of the sensor
+ *
+ * @param[out] coeff_array : BME68X_LEN_COEFF_ALL bytes, banks 0x8A, 0xE1 and 0x00 in that order
+ * @param[in,out] dev      : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_get_calib_raw(uint8_t *coeff_array, struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiInit
+ * \page bme68x_api_bme68x_set_calib_raw bme68x_set_calib_raw
+ * \code
+ * int8_t bme68x_set_calib_raw(const uint8_t *coeff_array, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API decodes raw calibration coefficients into the device
+ * structure without any bus access
+ *
+ * @param[in] coeff_array : Coefficients as returned by bme68x_get_calib_raw()
+ * @param[in,out] dev     : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_set_calib_raw(const uint8_t *coeff_array, struct bme68x_dev *dev);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiRegister Registers
@@ -225,6 +278,46 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
  */
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_parse_field_data bme68x_parse_field_data
+ * \code
+ * int8_t bme68x_parse_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API decodes and compensates a forced mode field that the
+ * caller read itself, e.g. with an asynchronous bus transfer, starting at
+ * BME68X_REG_FIELD0.
+ * @param[in]  buff    : BME68X_LEN_FIELD bytes read from the field registers.
+ * @param[out] data    : Structure instance to hold the data.
+ * @param[in,out] dev  : Structure instance of bme68x_dev
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning, BME68X_W_NO_NEW_DATA if the field holds no new data
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_parse_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_parse_all_field_data bme68x_parse_all_field_data
+ * \code
+ * int8_t bme68x_parse_all_field_data(const uint8_t *buff, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API decodes and compensates the three fields of a parallel
+ * or sequential mode read that the caller did itself, starting at
+ * BME68X_REG_FIELD0. The fields are sorted by measurement index like in
+ * bme68x_get_data().
+ * @param[in]  buff    : BME68X_LEN_FIELD * 3 bytes read from the field registers.
+ * @param[out] data    : Array of three structure instances to hold the data.
+ * @param[out] n_data  : Number of fields holding new data.
+ * @param[in,out] dev  : Structure instance of bme68x_dev
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning, BME68X_W_NO_NEW_DATA if no field holds new data
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_parse_all_field_data(const uint8_t *buff, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiConfig Configuration
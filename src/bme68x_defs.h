@@ -339,6 +339,19 @@
 /* Length of the interleaved buffer */
 #define BME68X_LEN_INTERLEAVE_BUFF                UINT8_C(20)
 
+/* Length of the shadowed control registers, CTRL_GAS_0(0x70) up to CONFIG(0x75) */
+#define BME68X_LEN_SHADOW_CTRL                    UINT8_C(6)
+
+/* Length of the shadowed heater registers, IDAC_HEAT0(0x50) up to SHD_HEATR_DUR(0x6E) */
+#define BME68X_LEN_SHADOW_HEATR                   UINT8_C(31)
+
+/* Maximum number of registers written in one heater configuration
+ * (10 res_heat, 10 gas_wait, shared heater duration, CTRL_GAS_0 and CTRL_GAS_1) */
+#define BME68X_LEN_HEATR_WRITE                    UINT8_C(23)
+
+/* Maximum length of a heater profile */
+#define BME68X_MAX_PROFILE_LEN                    UINT8_C(10)
+
 /* Coefficient index macros */
 
 /* Coefficient T2 LSB position */
@@ -463,6 +476,22 @@
 /* Enable gas measurement high */
 #define BME68X_ENABLE_GAS_MEAS_H                  UINT8_C(0x02)
 
+/* Register shadow macros */
+
+/* Control registers are shadowed */
+#define BME68X_SHADOW_CTRL                        UINT8_C(0x01)
+
+/* Heater registers are shadowed */
+#define BME68X_SHADOW_HEATR                       UINT8_C(0x02)
+
+/* Heater resistance cache macros */
+
+/* Number of cached heater resistance register values */
+#define BME68X_HEATR_CACHE_LEN                    UINT8_C(8)
+
+/* Width of an ambient temperature bucket of the cache in degree Celsius */
+#define BME68X_AMB_BUCKET_WIDTH                   INT8_C(5)
+
 /* Heater control macros */
 
 /* Enable heater */
@@ -765,6 +794,79 @@ struct bme68x_data
 
 };
 
+#ifdef BME68X_USE_FPU
+
+/*
+ * @brief Structure to hold calibration terms derived once from the raw
+ * coefficients, so that the float compensation needs no constant divisions
+ */
+struct bme68x_calib_derived
+{
+    /*! par_t1 / 1024 */
+    float t1_1024;
+
+    /*! par_t1 / 8192 */
+    float t1_8192;
+
+    /*! par_t3 * 16 */
+    float t3_16;
+
+    /*! par_p2 / 2^19 */
+    float p2_s;
+
+    /*! par_p3 / 2^33 */
+    float p3_s;
+
+    /*! par_p4 * 65536 */
+    float p4_s;
+
+    /*! par_p5 * 2 */
+    float p5_s;
+
+    /*! par_p6 / 131072 */
+    float p6_s;
+
+    /*! par_p7 * 128 */
+    float p7_s;
+
+    /*! par_p8 / 32768 */
+    float p8_s;
+
+    /*! par_p9 / 2^31 */
+    float p9_s;
+
+    /*! par_p10 / 2^41 */
+    float p10_s;
+
+    /*! par_p1 / 32768 */
+    float p1_32768;
+
+    /*! par_h1 * 16 */
+    float h1_s;
+
+    /*! par_h2 / 262144 */
+    float h2_s;
+
+    /*! par_h3 / 2 */
+    float h3_s;
+
+    /*! par_h4 / 16384 */
+    float h4_s;
+
+    /*! par_h5 / 1048576 */
+    float h5_s;
+
+    /*! par_h6 / 16384 */
+    float h6_s;
+
+    /*! par_h7 / 2097152 */
+    float h7_s;
+
+    /*! 1 / (1340 + 5 * range_sw_err), gas low variant */
+    float gas_inv_sw_err;
+};
+#endif
+
 /*
  * @brief Structure to hold the calibration coefficients
  */
@@ -856,6 +958,11 @@ struct bme68x_calib_data
 
     /*! Gas resistance range switching error coefficient */
     int8_t range_sw_err;
+#ifdef BME68X_USE_FPU
+
+    /*! Terms derived from the coefficients above by get_calib_data() */
+    struct bme68x_calib_derived derived;
+#endif
 };
 
 /*
@@ -913,6 +1020,58 @@ struct bme68x_heatr_conf
     uint16_t shared_heatr_dur;
 };
 
+/*
+ * @brief Write-through copy of the registers that only the driver writes.
+ * Lets the driver skip the read of a read-modify-write cycle and the write
+ * of registers that already hold the wanted value.
+ */
+struct bme68x_shadow
+{
+    /*! Registers CTRL_GAS_0(0x70) up to CONFIG(0x75) */
+    uint8_t ctrl[BME68X_LEN_SHADOW_CTRL];
+
+    /*! Registers IDAC_HEAT0(0x50) up to SHD_HEATR_DUR(0x6E) */
+    uint8_t heatr[BME68X_LEN_SHADOW_HEATR];
+
+    /*! Banks holding valid data. Refer @ref BME68X_SHADOW_CTRL and @ref BME68X_SHADOW_HEATR */
+    uint8_t valid;
+
+    /*! Number of bus transactions avoided thanks to the shadow */
+    uint32_t saved_xfers;
+};
+
+/*
+ * @brief Heater resistance register value computed for a target temperature
+ * and an ambient temperature bucket
+ */
+struct bme68x_heatr_cache_entry
+{
+    /*! Target temperature in degree Celsius */
+    uint16_t temp;
+
+    /*! Ambient temperature bucket. Refer @ref BME68X_AMB_BUCKET_WIDTH */
+    int8_t amb_bucket;
+
+    /*! Entry holds a value */
+    uint8_t valid;
+
+    /*! RES_HEAT_x register value */
+    uint8_t res_heat;
+};
+
+/*
+ * @brief Cache of heater resistance register values, so that reapplying a
+ * heater profile does not repeat the heater resistance calculation
+ */
+struct bme68x_heatr_cache
+{
+    /*! Cached values */
+    struct bme68x_heatr_cache_entry entry[BME68X_HEATR_CACHE_LEN];
+
+    /*! Entry replaced on the next miss */
+    uint8_t next;
+};
+
 /*
  * @brief BME68X device structure
  */
@@ -966,6 +1125,18 @@ struct bme68x_dev
 
     /*! Store the info messages */
     uint8_t info_msg;
+
+    /*!
+     * Skip res_heat, idac and gas_wait when reading field data, for
+     * callers that do not use them. Refer @ref en_dis
+     */
+    uint8_t skip_heatr_meta;
+
+    /*! Shadow of the control and heater registers, invalidated by a soft reset */
+    struct bme68x_shadow shadow;
+
+    /*! Heater resistance values, invalidated when the calibration data is read */
+    struct bme68x_heatr_cache heatr_cache;
 };
 
 #endif /* BME68X_DEFS_H_ */
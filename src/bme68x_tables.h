@@ -0,0 +1,69 @@
+/*
+ * Generated by tools/gen_bme68x_tables, do not edit.
+ * The file is pre-generated and checked in; the build does not run the
+ * generator. Regenerate it after changing the tables with:
+ *
+ *   gcc -O2 -Wall -o gen_bme68x_tables tools/gen_bme68x_tables/gen_bme68x_tables.c
+ *   ./gen_bme68x_tables > src/bme68x_tables.h
+ */
+
+#ifndef BME68X_TABLES_H_
+#define BME68X_TABLES_H_
+
+#include <stdint.h>
+
+#ifdef BME68X_USE_FPU
+
+/* (1 + k2[range] / 100) * 0.000000125 * 2^range, gas low variant */
+static const float bme68x_gas_low_scale[16] = {
+    1.25e-07f, 2.49999999e-07f, 4.99999999e-07f, 9.99999997e-07f,
+    2.0020002e-06f, 4.02799969e-06f, 7.99999998e-06f, 1.58719995e-05f,
+    3.19680003e-05f, 6.39999998e-05f, 0.000128f, 0.000255999999f,
+    0.000511999999f, 0.001024f, 0.00204799999f, 0.00409599999f,
+};
+
+/* 1 / (1 + k1[range] / 100), gas low variant */
+static const float bme68x_gas_low_k1_inv[16] = {
+    1.0f, 1.0f, 1.0f, 1.0f,
+    1.0f, 1.01010096f, 1.0f, 1.00806451f,
+    1.0f, 1.0f, 1.00200403f, 1.00502515f,
+    1.0f, 1.01010096f, 1.0f, 1.0f,
+};
+
+/* 1000000 * (262144 >> range), gas high variant */
+static const float bme68x_gas_high_num[16] = {
+    2.62144e+11f, 1.31072e+11f, 6.5536e+10f, 3.2768e+10f,
+    1.6384e+10f, 8.192e+09f, 4.096e+09f, 2.048e+09f,
+    1.024e+09f, 512000000.0f, 256000000.0f, 128000000.0f,
+    64000000.0f, 32000000.0f, 16000000.0f, 8000000.0f,
+};
+
+#else
+
+/* 2^31 * (1 + k1[range] / 100), gas low variant */
+static const uint32_t bme68x_gas_low_table1[16] = {
+    UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
+    UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777),
+    UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2143188679), UINT32_C(2136746228),
+    UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2147483647),
+};
+
+/* 4096000000 / 2^range / (1 + k2[range] / 100), gas low variant */
+static const uint32_t bme68x_gas_low_table2[16] = {
+    UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000),
+    UINT32_C(255744255), UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064),
+    UINT32_C(16016016), UINT32_C(8000000), UINT32_C(4000000), UINT32_C(2000000),
+    UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000),
+};
+
+/* 10000 * (262144 >> range), gas high variant */
+static const uint32_t bme68x_gas_high_num[16] = {
+    UINT32_C(2621440000), UINT32_C(1310720000), UINT32_C(655360000), UINT32_C(327680000),
+    UINT32_C(163840000), UINT32_C(81920000), UINT32_C(40960000), UINT32_C(20480000),
+    UINT32_C(10240000), UINT32_C(5120000), UINT32_C(2560000), UINT32_C(1280000),
+    UINT32_C(640000), UINT32_C(320000), UINT32_C(160000), UINT32_C(80000),
+};
+
+#endif
+
+#endif /* BME68X_TABLES_H_ */
@@ -14,7 +14,7 @@
 #define NTP_PORT 123
 #define NTP_DELTA 2208988800 // Sekunder mellan 1900 och 1970
 
-static bool is_synced = false;
+static volatile bool is_synced = false; // Sätts bara av NTP-svaret
 
 typedef struct {
     ip_addr_t server_address;
@@ -119,6 +119,10 @@ bool datetime_is_synced(void) {
     return (t->tm_year > 70); // 70 betyder år 1970. Allt över det är "synkat".
 }
 
+bool datetime_is_ntp_synced(void) {
+    return is_synced;
+}
+
 // Manuell fallback om NTP är blockerat
 void datetime_set_manual(int year, int mon, int day, int hour, int min, int sec) {
     struct tm t = {0};
@@ -132,5 +136,4 @@ void datetime_set_manual(int year, int mon, int day, int hour, int min, int sec)
     time_t time_val = mktime(&t);
     struct timeval tv = { .tv_sec = time_val, .tv_usec = 0 };
     settimeofday(&tv, NULL);
-    is_synced = true;
 }
@@ -10,6 +10,9 @@ void datetime_init(void);
 // Hjälpfunktion: Kollar om tiden har blivit synkad än
 bool datetime_is_synced(void);
 
+// Sann först när tiden kommit från NTP, inte efter datetime_set_manual()
+bool datetime_is_ntp_synced(void);
+
 // Hämtar aktuell tid (med din +2h justering)
 struct tm* datetime_get_time(void);
 
@@ -0,0 +1,19 @@
+#include "deadband.h"
+
+int64_t deadband_limit(const deadband_band_t *band, int32_t ref) {
+    int64_t rel = ((int64_t)ref < 0 ? -(int64_t)ref : ref) * band->rel_permille / 1000;
+    return band->abs > rel ? band->abs : rel;
+}
+
+bool deadband_exceeded(const deadband_ref_t *ref, const deadband_band_t *band, size_t ch, int32_t value) {
+    if (ch >= DEADBAND_MAX_CHANNELS || !(ref->valid & (1u << ch))) return true;
+
+    int64_t diff = (int64_t)value - ref->value[ch];
+    return (diff < 0 ? -diff : diff) > deadband_limit(band, ref->value[ch]);
+}
+
+void deadband_set(deadband_ref_t *ref, size_t ch, int32_t value) {
+    if (ch >= DEADBAND_MAX_CHANNELS) return;
+    ref->value[ch] = value;
+    ref->valid |= (uint8_t)(1u << ch);
+}
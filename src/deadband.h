@@ -0,0 +1,33 @@
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Deadband för ändringsstyrd publicering: ett värde räknas som ändrat först när
+// det skiljer mer än bandet från det senast publicerade. Bandet är det största
+// av ett absolut värde och en andel av det publicerade värdet.
+
+#define DEADBAND_MAX_CHANNELS 8
+
+typedef struct {
+    int32_t abs;            // I kanalens enhet (t.ex. °C x100)
+    uint16_t rel_permille;  // Promille av senast publicerade värdet
+} deadband_band_t;
+
+typedef struct {
+    int32_t value[DEADBAND_MAX_CHANNELS];   // Senast publicerade värde per kanal
+    uint8_t valid;                          // Bit per kanal som har publicerats
+} deadband_ref_t;
+
+// Bandets halva bredd runt referensvärdet ref
+int64_t deadband_limit(const deadband_band_t *band, int32_t ref);
+
+// true om value ligger utanför bandet, eller om kanalen aldrig har publicerats
+bool deadband_exceeded(const deadband_ref_t *ref, const deadband_band_t *band, size_t ch, int32_t value);
+
+// Kom ihåg det publicerade värdet
+void deadband_set(deadband_ref_t *ref, size_t ch, int32_t value);
+
+#endif
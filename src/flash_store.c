@@ -0,0 +1,78 @@
+#include "flash_store.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include <string.h>
+
+// Maxtid att vänta på att andra kärnan/avbrott släpper flashen
+#define FLASH_STORE_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;
+    size_t len;
+    bool erase;
+} flash_write_op_t;
+
+// Hela sidor som ska programmeras
+static uint8_t page_buf[FLASH_STORE_MAX_LEN];
+
+static uint32_t sector_offset(uint sector) {
+    return PICO_FLASH_SIZE_BYTES - (sector + 1) * FLASH_SECTOR_SIZE;
+}
+
+const uint8_t *flash_store_data(uint sector) {
+    return (const uint8_t *)(XIP_BASE + sector_offset(sector));
+}
+
+// Körs med avbrotten avstängda, XIP går inte att använda under tiden
+static void do_write(void *param) {
+    const flash_write_op_t *op = param;
+
+    if (op->erase) flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    if (op->len) flash_range_program(op->offset, op->data, op->len);
+}
+
+bool flash_store_write(uint sector, const void *data, size_t len) {
+    // Programmering sker i hela sidor, resten fylls med 0xFF som i raderad flash
+    size_t padded = (len + FLASH_PAGE_SIZE - 1) & ~(size_t)(FLASH_PAGE_SIZE - 1);
+
+    if (len == 0 || len > FLASH_STORE_MAX_LEN) return false;
+
+    memset(page_buf, 0xFF, padded);
+    memcpy(page_buf, data, len);
+
+    flash_write_op_t op = { sector_offset(sector), page_buf, padded, true };
+    return flash_safe_execute(do_write, &op, FLASH_STORE_TIMEOUT_MS) == PICO_OK;
+}
+
+bool flash_store_program(uint sector, size_t offset, const void *data, size_t len) {
+    // 0xFF runt datat lämnar redan skrivna bytes i samma sida oförändrade
+    size_t start = offset & ~(size_t)(FLASH_PAGE_SIZE - 1);
+    size_t padded = ((offset + len + FLASH_PAGE_SIZE - 1) & ~(size_t)(FLASH_PAGE_SIZE - 1)) - start;
+
+    if (len == 0 || offset + len > FLASH_SECTOR_SIZE || padded > FLASH_STORE_MAX_LEN) return false;
+
+    memset(page_buf, 0xFF, padded);
+    memcpy(page_buf + (offset - start), data, len);
+
+    flash_write_op_t op = { sector_offset(sector) + (uint32_t)start, page_buf, padded, false };
+    return flash_safe_execute(do_write, &op, FLASH_STORE_TIMEOUT_MS) == PICO_OK;
+}
+
+bool flash_store_erase(uint sector) {
+    flash_write_op_t op = { sector_offset(sector), NULL, 0, true };
+    return flash_safe_execute(do_write, &op, FLASH_STORE_TIMEOUT_MS) == PICO_OK;
+}
+
+uint32_t flash_store_crc32(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,30 @@
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include "pico/stdlib.h"
+#include <stdbool.h>
+
+// Sektorer räknas bakifrån från slutet av flashminnet, långt efter programmet
+#define FLASH_STORE_SECTOR_CALIB 0  // BME68x-kalibrering
+#define FLASH_STORE_SECTOR_BASELINE 1 // Gasbaslinjer, logg som skrivs utan radering
+
+// Största post som kan skrivas med flash_store_write()
+#define FLASH_STORE_MAX_LEN 1024
+
+// Sektorns innehåll, läses direkt via XIP (0xFF om sektorn är raderad)
+const uint8_t *flash_store_data(uint sector);
+
+// Radera sektorn och skriv 'len' bytes i början av den. Säker mot avbrott och andra kärnan.
+bool flash_store_write(uint sector, const void *data, size_t len);
+
+// Skriv 'len' bytes på 'offset' i sektorn utan att radera. Flash kan bara nolla
+// bitar, så området måste vara raderat (0xFF). Resten av berörda sidor lämnas orört.
+bool flash_store_program(uint sector, size_t offset, const void *data, size_t len);
+
+// Radera hela sektorn
+bool flash_store_erase(uint sector);
+
+// CRC-32 (samma som zlib/Ethernet) för att validera poster
+uint32_t flash_store_crc32(const void *data, size_t len);
+
+#endif
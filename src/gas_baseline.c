@@ -0,0 +1,151 @@
+#include "gas_baseline.h"
+#include "flash_store.h"
+#include "hardware/flash.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+// En post per sparning, 32 bytes så att 128 poster ryms per radering.
+// Senaste giltiga posten för ett id gäller.
+#define BASELINE_MAGIC 0x4C423642u // "B6BL"
+#define BASELINE_VERSION 1
+#define BASELINE_SLOTS (FLASH_SECTOR_SIZE / sizeof(baseline_record_t))
+#define BASELINE_MAX_IDS 8          // Poster som flyttas med när sektorn packas om
+
+// Första sparningen görs när medelvärdet har så här många mätningar
+#define BASELINE_FIRST_SAVE 8
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t id;
+    uint8_t pad[2];
+    uint32_t time_s;        // Unix-tid när posten skrevs
+    uint32_t gas;
+    int32_t temperature;
+    uint32_t humidity;
+    uint32_t samples;
+    uint32_t crc;           // CRC-32 över allt ovanför
+} baseline_record_t;
+
+static const baseline_record_t *records(void) {
+    return (const baseline_record_t *)flash_store_data(FLASH_STORE_SECTOR_BASELINE);
+}
+
+static bool record_valid(const baseline_record_t *rec) {
+    return rec->magic == BASELINE_MAGIC && rec->version == BASELINE_VERSION &&
+           rec->crc == flash_store_crc32(rec, offsetof(baseline_record_t, crc));
+}
+
+static bool record_erased(const baseline_record_t *rec) {
+    const uint8_t *p = (const uint8_t *)rec;
+
+    for (size_t i = 0; i < sizeof(*rec); i++) {
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// Första lediga plats efter den senast skrivna posten, BASELINE_SLOTS om sektorn är full
+static size_t first_free(void) {
+    const baseline_record_t *rec = records();
+    size_t n = BASELINE_SLOTS;
+
+    while (n > 0 && record_erased(&rec[n - 1])) n--;
+    return n;
+}
+
+static const baseline_record_t *find_latest(uint8_t id) {
+    const baseline_record_t *rec = records();
+    const baseline_record_t *latest = NULL;
+
+    for (size_t i = 0; i < BASELINE_SLOTS; i++) {
+        if (record_valid(&rec[i]) && rec[i].id == id) latest = &rec[i];
+    }
+    return latest;
+}
+
+void gas_baseline_init(gas_baseline_t *b, uint8_t id) {
+    memset(b, 0, sizeof(*b));
+    b->id = id;
+}
+
+bool gas_baseline_restore(gas_baseline_t *b, uint32_t now_s, int32_t temperature, uint32_t humidity) {
+    const baseline_record_t *rec = find_latest(b->id);
+
+    b->restore_done = true;
+    if (!rec || now_s < rec->time_s || now_s - rec->time_s > GAS_BASELINE_MAX_AGE_S) return false;
+    if (temperature - rec->temperature > GAS_BASELINE_MAX_TEMP_DIFF ||
+        rec->temperature - temperature > GAS_BASELINE_MAX_TEMP_DIFF) return false;
+    if ((humidity > rec->humidity ? humidity - rec->humidity : rec->humidity - humidity) > GAS_BASELINE_MAX_HUM_DIFF) {
+        return false;
+    }
+
+    b->gas = rec->gas;
+    b->temperature = rec->temperature;
+    b->humidity = rec->humidity;
+    b->valid = true;
+    b->restored = true;
+    return true;
+}
+
+void gas_baseline_update(gas_baseline_t *b, uint32_t gas, int32_t temperature, uint32_t humidity) {
+    b->samples++;
+    if (!b->valid) {
+        b->gas = gas;
+        b->temperature = temperature;
+        b->humidity = humidity;
+        b->valid = true;
+        return;
+    }
+
+    // Exponentiellt medelvärde, i heltal
+    b->gas = (uint32_t)((int64_t)b->gas + ((int64_t)gas - b->gas) / GAS_BASELINE_SAMPLES);
+    b->temperature += (temperature - b->temperature) / GAS_BASELINE_SAMPLES;
+    b->humidity = (uint32_t)((int64_t)b->humidity + ((int64_t)humidity - b->humidity) / GAS_BASELINE_SAMPLES);
+}
+
+// Sektorn är full: radera den och skriv tillbaka senaste posten för övriga sensorer
+static size_t compact(uint8_t skip_id) {
+    baseline_record_t keep[BASELINE_MAX_IDS];
+    size_t n = 0;
+    const baseline_record_t *rec = records();
+
+    for (size_t i = BASELINE_SLOTS; i-- > 0 && n < BASELINE_MAX_IDS;) {
+        if (!record_valid(&rec[i]) || rec[i].id == skip_id) continue;
+        bool seen = false;
+        for (size_t k = 0; k < n; k++) seen |= keep[k].id == rec[i].id;
+        if (!seen) keep[n++] = rec[i];
+    }
+
+    if (!flash_store_erase(FLASH_STORE_SECTOR_BASELINE)) return BASELINE_SLOTS;
+    if (n && !flash_store_program(FLASH_STORE_SECTOR_BASELINE, 0, keep, n * sizeof(keep[0]))) return BASELINE_SLOTS;
+    return n;
+}
+
+bool gas_baseline_save(gas_baseline_t *b, uint32_t now_ms, uint32_t now_s) {
+    if (!b->valid || b->samples == 0) return false;
+    if (b->saved_ms ? now_ms - b->saved_ms < GAS_BASELINE_SAVE_MS : b->samples < BASELINE_FIRST_SAVE) return false;
+    b->saved_ms = now_ms;
+
+    baseline_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = BASELINE_MAGIC;
+    rec.version = BASELINE_VERSION;
+    rec.id = b->id;
+    rec.time_s = now_s;
+    rec.gas = b->gas;
+    rec.temperature = b->temperature;
+    rec.humidity = b->humidity;
+    rec.samples = b->samples;
+    rec.crc = flash_store_crc32(&rec, offsetof(baseline_record_t, crc));
+
+    size_t slot = first_free();
+    if (slot >= BASELINE_SLOTS) slot = compact(b->id);
+    if (slot >= BASELINE_SLOTS ||
+        !flash_store_program(FLASH_STORE_SECTOR_BASELINE, slot * sizeof(rec), &rec, sizeof(rec))) {
+        printf("Gasbaslinje: kunde inte spara i flash\n");
+        return false;
+    }
+    return true;
+}
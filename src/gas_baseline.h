@@ -0,0 +1,54 @@
+#ifndef GAS_BASELINE_H
+#define GAS_BASELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Löpande gasbaslinje per sensor som sparas i flash, så att en omstartad nod
+// kan fortsätta från den i stället för att lära in den från början.
+// Posterna läggs efter varandra i FLASH_STORE_SECTOR_BASELINE och sektorn
+// raderas först när den är full, så de flesta sparningar kostar en sidskrivning.
+
+// Medelvärdet följer ungefär de senaste så här många gasmätningarna
+#ifndef GAS_BASELINE_SAMPLES
+#define GAS_BASELINE_SAMPLES 64
+#endif
+
+// Spara baslinjen med det här intervallet
+#ifndef GAS_BASELINE_SAVE_MS
+#define GAS_BASELINE_SAVE_MS (30 * 60 * 1000)
+#endif
+
+// Äldsta baslinje som återställs, och hur mycket omgivningen får ha ändrats
+#ifndef GAS_BASELINE_MAX_AGE_S
+#define GAS_BASELINE_MAX_AGE_S (60 * 60)
+#endif
+#define GAS_BASELINE_MAX_TEMP_DIFF 300      // °C x100
+#define GAS_BASELINE_MAX_HUM_DIFF 10000     // % x1000
+
+typedef struct {
+    uint8_t id;             // (I2C-block << 7) | adress
+    bool valid;             // Baslinjen har ett värde, återställt eller inlärt
+    bool restored;          // Värdet kom från flash vid start
+    bool restore_done;      // Återställningen är prövad (första mätningen med NTP-tid)
+    uint32_t gas;           // ohm
+    int32_t temperature;    // °C x100, omgivningen när baslinjen lärdes in
+    uint32_t humidity;      // % x1000
+    uint32_t samples;       // Gasmätningar sedan start
+    uint32_t saved_ms;      // När baslinjen senast sparades (ms sedan start)
+} gas_baseline_t;
+
+void gas_baseline_init(gas_baseline_t *b, uint8_t id);
+
+// Återställ sparad baslinje om den är högst GAS_BASELINE_MAX_AGE_S gammal och
+// temperatur och luftfuktighet ligger nära dagens. now_s är Unix-tid.
+bool gas_baseline_restore(gas_baseline_t *b, uint32_t now_s, int32_t temperature, uint32_t humidity);
+
+// Lägg till en gasmätning från en uppvärmd sensor
+void gas_baseline_update(gas_baseline_t *b, uint32_t gas, int32_t temperature, uint32_t humidity);
+
+// Spara baslinjen om GAS_BASELINE_SAVE_MS har gått sedan förra gången.
+// Returnerar true om något skrevs till flash.
+bool gas_baseline_save(gas_baseline_t *b, uint32_t now_ms, uint32_t now_s);
+
+#endif
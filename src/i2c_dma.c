@@ -0,0 +1,233 @@
+#include "i2c_dma.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+// Maxtid för en blockerande överföring (64 bytes vid 100 kHz tar ca 6 ms)
+#define I2C_DMA_TIMEOUT_US 20000
+
+// Tillstånd per I2C-block (i2c0/i2c1)
+typedef struct {
+    i2c_inst_t *i2c;
+    int tx_chan;
+    int rx_chan;
+    volatile bool busy;
+    volatile bool ok;
+    bool reading;
+    i2c_dma_cb_t cb;
+    void *user_data;
+    // Kommandoord till IC_DATA_CMD: registeradress + en post per byte
+    uint32_t cmd[I2C_DMA_MAX_LEN + 1];
+} i2c_dma_bus_t;
+
+static i2c_dma_bus_t buses[2];
+
+static i2c_dma_bus_t *bus_for(i2c_inst_t *i2c) {
+    return &buses[i2c_hw_index(i2c)];
+}
+
+static void bus_finish(i2c_dma_bus_t *b, bool ok) {
+    i2c_get_hw(b->i2c)->intr_mask = 0;
+    b->ok = ok;
+    b->busy = false;
+    if (b->cb) b->cb(ok, b->user_data);
+    __sev(); // Väck den som väntar i __wfe()
+}
+
+// Gemensam IRQ: STOP_DET betyder att transaktionen är klar, TX_ABRT att den avbröts (t.ex. NACK)
+static void bus_irq(i2c_dma_bus_t *b) {
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+    uint32_t stat = hw->intr_stat;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        dma_channel_abort(b->tx_chan);
+        dma_channel_abort(b->rx_chan);
+        (void)hw->clr_tx_abrt;
+        (void)hw->clr_stop_det;
+        bus_finish(b, false);
+        return;
+    }
+
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        // Efter STOP ligger sista bytes redan i RX-FIFO, DMA tömmer den på några cykler
+        if (b->reading) {
+            while (dma_channel_is_busy(b->rx_chan)) tight_loop_contents();
+        }
+        bus_finish(b, true);
+    }
+}
+
+static void i2c0_dma_irq(void) { bus_irq(&buses[0]); }
+static void i2c1_dma_irq(void) { bus_irq(&buses[1]); }
+
+static void bus_abort(i2c_dma_bus_t *b) {
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+    hw->intr_mask = 0;
+    dma_channel_abort(b->tx_chan);
+    dma_channel_abort(b->rx_chan);
+    hw->enable = 0; // Tömmer FIFO:erna
+    hw->enable = 1;
+    b->ok = false;
+    b->busy = false;
+    if (b->cb) b->cb(false, b->user_data); // Asynkron ägare får veta att överföringen dog
+}
+
+static bool bus_wait(i2c_dma_bus_t *b) {
+    absolute_time_t deadline = make_timeout_time_us(I2C_DMA_TIMEOUT_US);
+    while (b->busy) {
+        if (best_effort_wfe_or_timeout(deadline)) {
+            if (!b->busy) break;
+            bus_abort(b);
+            return false;
+        }
+    }
+    return b->ok;
+}
+
+// Ta bussen. Atomiskt eftersom överföringar även startas från avbrott (t.ex. timeralarm).
+static bool bus_claim(i2c_dma_bus_t *b) {
+    uint32_t irq = save_and_disable_interrupts();
+    bool claimed = b->i2c && !b->busy;
+    if (claimed) b->busy = true;
+    restore_interrupts(irq);
+    return claimed;
+}
+
+// Vänta tills bussen går att ta. false om bussen inte är initierad.
+static bool bus_claim_blocking(i2c_dma_bus_t *b) {
+    while (!bus_claim(b)) {
+        if (!b->i2c) return false;
+        bus_wait(b);
+    }
+    return true;
+}
+
+// Ladda kommandona i TX-kanalen (och RX-kanalen vid läsning) och kör igång
+static void bus_start(i2c_dma_bus_t *b, uint8_t addr, size_t n_cmd, uint8_t *dst, size_t rx_len) {
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+    (void)hw->clr_intr;
+
+    b->reading = (rx_len > 0);
+    if (b->reading) {
+        dma_channel_config rx = dma_channel_get_default_config(b->rx_chan);
+        channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+        channel_config_set_read_increment(&rx, false);
+        channel_config_set_write_increment(&rx, true);
+        channel_config_set_dreq(&rx, i2c_get_dreq(b->i2c, false));
+        dma_channel_configure(b->rx_chan, &rx, dst, &hw->data_cmd, rx_len, true);
+    }
+
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    dma_channel_config tx = dma_channel_get_default_config(b->tx_chan);
+    channel_config_set_transfer_data_size(&tx, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx, true);
+    channel_config_set_write_increment(&tx, false);
+    channel_config_set_dreq(&tx, i2c_get_dreq(b->i2c, true));
+    dma_channel_configure(b->tx_chan, &tx, &hw->data_cmd, b->cmd, n_cmd, true);
+}
+
+bool i2c_dma_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint baudrate) {
+    i2c_dma_bus_t *b = bus_for(i2c);
+
+    i2c_init(i2c, baudrate);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+
+    if (!b->i2c) {
+        b->i2c = i2c;
+        b->tx_chan = dma_claim_unused_channel(false);
+        b->rx_chan = dma_claim_unused_channel(false);
+        if (b->tx_chan < 0 || b->rx_chan < 0) {
+            printf("I2C DMA: inga lediga DMA-kanaler\n");
+            b->i2c = NULL;
+            return false;
+        }
+
+        uint irq = I2C0_IRQ + i2c_hw_index(i2c);
+        irq_set_exclusive_handler(irq, i2c_hw_index(i2c) ? i2c1_dma_irq : i2c0_dma_irq);
+        irq_set_enabled(irq, true);
+    }
+
+    b->busy = false;
+    return true;
+}
+
+// Bussen måste vara tagen med bus_claim()
+static void read_start(i2c_dma_bus_t *b, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                       i2c_dma_cb_t cb, void *user_data) {
+    // Registeradress, sedan RESTART och en läs-kommando per byte, STOP på sista
+    b->cmd[0] = reg;
+    for (size_t i = 1; i <= len; i++) {
+        b->cmd[i] = I2C_IC_DATA_CMD_CMD_BITS;
+    }
+    b->cmd[1] |= I2C_IC_DATA_CMD_RESTART_BITS;
+    b->cmd[len] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    b->cb = cb;
+    b->user_data = user_data;
+    bus_start(b, addr, len + 1, dst, len);
+}
+
+static void write_start(i2c_dma_bus_t *b, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len,
+                        i2c_dma_cb_t cb, void *user_data) {
+    b->cmd[0] = reg;
+    for (size_t i = 0; i < len; i++) {
+        b->cmd[i + 1] = src[i];
+    }
+    b->cmd[len] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    b->cb = cb;
+    b->user_data = user_data;
+    bus_start(b, addr, len + 1, NULL, 0);
+}
+
+bool i2c_dma_read_reg_async(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                            i2c_dma_cb_t cb, void *user_data) {
+    i2c_dma_bus_t *b = bus_for(i2c);
+    if (len == 0 || len > I2C_DMA_MAX_LEN || !bus_claim(b)) return false;
+
+    read_start(b, addr, reg, dst, len, cb, user_data);
+    return true;
+}
+
+bool i2c_dma_write_reg_async(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len,
+                             i2c_dma_cb_t cb, void *user_data) {
+    i2c_dma_bus_t *b = bus_for(i2c);
+    if (len > I2C_DMA_MAX_LEN || !bus_claim(b)) return false;
+
+    write_start(b, addr, reg, src, len, cb, user_data);
+    return true;
+}
+
+bool i2c_dma_read_reg(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len) {
+    i2c_dma_bus_t *b = bus_for(i2c);
+    if (len == 0 || len > I2C_DMA_MAX_LEN) return false;
+
+    // Vänta ut en pågående asynkron överföring först
+    if (!bus_claim_blocking(b)) return false;
+    read_start(b, addr, reg, dst, len, NULL, NULL);
+    return bus_wait(b);
+}
+
+bool i2c_dma_write_reg(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len) {
+    i2c_dma_bus_t *b = bus_for(i2c);
+    if (len > I2C_DMA_MAX_LEN) return false;
+
+    if (!bus_claim_blocking(b)) return false;
+    write_start(b, addr, reg, src, len, NULL, NULL);
+    return bus_wait(b);
+}
+
+bool i2c_dma_busy(i2c_inst_t *i2c) {
+    return bus_for(i2c)->busy;
+}
@@ -0,0 +1,34 @@
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include <stdbool.h>
+
+// Längsta registerläsning/-skrivning i en transaktion (tre BME68x-fält är 51 bytes)
+#define I2C_DMA_MAX_LEN 64
+
+// Anropas från IRQ när en asynkron överföring är klar. Håll den kort!
+// Anropas även (med ok = false) om en blockerande anropare fick avbryta en hängd överföring.
+// Asynkrona överföringar får startas från avbrott, t.ex. från ett timeralarm.
+typedef void (*i2c_dma_cb_t)(bool ok, void *user_data);
+
+// Initiera I2C-bussen med DMA-kanaler för TX/RX. baudrate upp till 1 MHz (Fast-mode Plus).
+bool i2c_dma_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint baudrate);
+
+// Starta läsning av 'len' bytes från register 'reg'. Returnerar direkt, cb anropas när bytes ligger i dst.
+bool i2c_dma_read_reg_async(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                            i2c_dma_cb_t cb, void *user_data);
+
+// Starta skrivning av 'len' bytes till register 'reg'. Data kopieras, src får återanvändas direkt.
+bool i2c_dma_write_reg_async(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len,
+                             i2c_dma_cb_t cb, void *user_data);
+
+// Blockerande varianter för BME68x-callbackarna. Sover med __wfe() medan DMA jobbar.
+bool i2c_dma_read_reg(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len);
+bool i2c_dma_write_reg(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len);
+
+// true medan en överföring pågår på bussen
+bool i2c_dma_busy(i2c_inst_t *i2c);
+
+#endif
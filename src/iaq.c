@@ -0,0 +1,58 @@
+#include "iaq.h"
+#include <string.h>
+
+// Luftfuktigheten väger 25 % av betyget (bäst vid 40 %RH), gasen 75 %
+#define IAQ_HUM_OPTIMUM 40000       // % x1000
+#define IAQ_HUM_WEIGHT 250          // Promille av betyget
+#define IAQ_GAS_WEIGHT 750
+
+// Gasresistansen omräknad till 40 %RH. Fuktig luft sänker resistansen.
+static uint32_t hum_compensate(uint32_t gas, uint32_t humidity) {
+    int64_t hum = humidity > 100000 ? 100000 : humidity;
+    int64_t factor = 1000 + IAQ_HUM_COMP_PERMILLE * (hum - IAQ_HUM_OPTIMUM) / 1000;
+
+    return (uint32_t)((int64_t)gas * factor / 1000);
+}
+
+void iaq_init(iaq_t *iaq) {
+    memset(iaq, 0, sizeof(*iaq));
+}
+
+void iaq_seed(iaq_t *iaq, uint32_t gas, uint32_t humidity) {
+    iaq->baseline = hum_compensate(gas, humidity);
+    iaq->seeded = iaq->baseline > 0;
+}
+
+static uint8_t accuracy(const iaq_t *iaq) {
+    if (iaq->baseline == 0) return IAQ_ACCURACY_NONE;
+    if (iaq->samples >= IAQ_SAMPLES_HIGH || (iaq->seeded && iaq->samples >= IAQ_SAMPLES_LOW)) return IAQ_ACCURACY_HIGH;
+    if (iaq->samples >= IAQ_SAMPLES_LOW || iaq->seeded) return IAQ_ACCURACY_MEDIUM;
+    return IAQ_ACCURACY_LOW;
+}
+
+uint16_t iaq_update(iaq_t *iaq, const bme680_reading_t *reading) {
+    if (!reading->has_gas || reading->gas == 0) return iaq->index;
+
+    uint32_t comp = hum_compensate(reading->gas, reading->humidity);
+    int64_t diff = (int64_t)comp - iaq->baseline;
+
+    // Baslinjen följer renare luft snabbt och sämre luft långsamt
+    if (iaq->baseline == 0) {
+        iaq->baseline = comp;
+    } else {
+        iaq->baseline = (uint32_t)(iaq->baseline + diff / (diff > 0 ? IAQ_BASELINE_UP : IAQ_BASELINE_DOWN));
+    }
+    iaq->samples++;
+
+    // Betyg i promille, 1000 = bäst
+    uint32_t hum = reading->humidity > 100000 ? 100000 : reading->humidity;
+    uint32_t hum_score = hum < IAQ_HUM_OPTIMUM ?
+        IAQ_HUM_WEIGHT * hum / IAQ_HUM_OPTIMUM :
+        IAQ_HUM_WEIGHT * (100000 - hum) / (100000 - IAQ_HUM_OPTIMUM);
+    uint32_t gas_score = comp >= iaq->baseline ? IAQ_GAS_WEIGHT :
+        (uint32_t)((uint64_t)IAQ_GAS_WEIGHT * comp / iaq->baseline);
+
+    iaq->index = (uint16_t)((1000 - hum_score - gas_score) / 2);
+    iaq->accuracy = accuracy(iaq);
+    return iaq->index;
+}
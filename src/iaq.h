@@ -0,0 +1,54 @@
+#ifndef IAQ_H
+#define IAQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bme680.h"
+
+// IAQ-index (0 = ren luft, 500 = mycket dålig) från gasresistans och luftfuktighet.
+// Gasresistansen kompenseras för luftfuktigheten och jämförs med en baslinje för
+// ren luft som följs exponentiellt: snabbt uppåt (renare luft än baslinjen) och
+// långsamt nedåt. Konstant minne och tid per mätning, bara heltal.
+
+// Hur snabbt baslinjen följer gasvärdet, i antal mätningar
+#ifndef IAQ_BASELINE_UP
+#define IAQ_BASELINE_UP 8
+#endif
+#ifndef IAQ_BASELINE_DOWN
+#define IAQ_BASELINE_DOWN 4096
+#endif
+
+// Gasresistansen ändras ungefär så här många promille per %RH, räknat från 40 %RH
+#ifndef IAQ_HUM_COMP_PERMILLE
+#define IAQ_HUM_COMP_PERMILLE 15
+#endif
+
+// Mätningar innan noggrannheten räknas som låg (1) respektive hög (3)
+#define IAQ_SAMPLES_LOW 20
+#define IAQ_SAMPLES_HIGH 240
+
+typedef enum {
+    IAQ_ACCURACY_NONE = 0,  // Ingen baslinje än
+    IAQ_ACCURACY_LOW,       // Baslinjen lärs in
+    IAQ_ACCURACY_MEDIUM,    // Baslinjen har följt gasvärdet en stund, eller återställdes nyss
+    IAQ_ACCURACY_HIGH,      // Baslinjen har följt gasvärdet i IAQ_SAMPLES_HIGH mätningar
+} iaq_accuracy_t;
+
+typedef struct {
+    uint32_t baseline;      // Kompenserad gasresistans i ren luft (ohm), 0 = ingen
+    uint32_t samples;
+    bool seeded;            // Baslinjen kom från gas_baseline efter omstart
+    uint16_t index;         // Senaste IAQ-index, 0-500
+    uint8_t accuracy;       // iaq_accuracy_t
+} iaq_t;
+
+void iaq_init(iaq_t *iaq);
+
+// Starta från en sparad gasbaslinje (ohm vid luftfuktigheten humidity, % x1000)
+void iaq_seed(iaq_t *iaq, uint32_t gas, uint32_t humidity);
+
+// Uppdatera med en mätning från en uppvärmd sensor. Mätningar utan gas ignoreras.
+// Returnerar indexet.
+uint16_t iaq_update(iaq_t *iaq, const bme680_reading_t *reading);
+
+#endif
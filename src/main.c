@@ -1,5 +1,6 @@
 #include "lwip/apps/sntp.h"
 #include <stdio.h>
+#include <stdarg.h>
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
 #include "hardware/i2c.h"
@@ -9,11 +10,92 @@
 #include "config.h"
 #include "lwip/dns.h"
 #include "datetime.h"
-
-// I2C-pinnar
+#include "warmup.h"
+#include "gas_baseline.h"
+#include "iaq.h"
+#include "stats.h"
+#include "deadband.h"
+#include "predict.h"
+
+// I2C-pinnar (i2c0)
 #define SDA_PIN 4
 #define SCL_PIN 5
 
+// Andra I2C-blocket (i2c1) för fler sensorer
+#define SDA1_PIN 6
+#define SCL1_PIN 7
+
+// Mättakt. Med pipelinen triggas nästa mätning direkt efter läsningen, så den
+// pågår medan vi formaterar och skickar och är klar när nästa cykel börjar.
+#ifndef SAMPLE_INTERVAL_MS
+#define SAMPLE_INTERVAL_MS 5000
+#endif
+#ifndef SENSOR_PIPELINE
+#define SENSOR_PIPELINE 1
+#endif
+
+// Multi-rate: T/H/P mäts varje cykel med värmaren avslagen (ca 40 ms per
+// mätning), gas bara var GAS_INTERVAL_MS. Värmaren (320 °C i 150 ms) går då
+// i en cykel av GAS_EVERY_CYCLES i stället för i varje.
+#ifndef GAS_INTERVAL_MS
+#define GAS_INTERVAL_MS 30000
+#endif
+#define GAS_EVERY_CYCLES (GAS_INTERVAL_MS / SAMPLE_INTERVAL_MS > 0 ? GAS_INTERVAL_MS / SAMPLE_INTERVAL_MS : 1)
+
+// Kontinuerligt läge (BME688): sensorn mäter själv med hårdvarans IIR-filter och
+// varje läsning blir en enda DMA-överföring. BME680 får bara filtret.
+#ifndef SENSOR_CONTINUOUS
+#define SENSOR_CONTINUOUS 0
+#endif
+#define SENSOR_FILTER BME68X_FILTER_SIZE_3
+#define SENSOR_ODR BME68X_ODR_1000_MS
+
+// Skriv ut mättidshistogrammet ungefär var femte minut
+#define TIMING_REPORT_CYCLES ((5 * 60 * 1000) / SAMPLE_INTERVAL_MS > 0 ? (5 * 60 * 1000) / SAMPLE_INTERVAL_MS : 1)
+
+// Publicering startar när alla sensorer är stabila (se warmup.h), men senast
+// efter WARMUP_MAX_MS. Under uppvärmningen mäts gas i varje cykel.
+#ifndef WARMUP_MAX_MS
+#define WARMUP_MAX_MS (30 * 60 * 1000)
+#endif
+
+// Statistikfönster: när ett fönster stängs publiceras medelvärde, standardavvikelse,
+// min, max och senaste värde per kanal. Mätningarna görs lika tätt som förut men
+// skickas bara som sammanfattningar, om inte PUBLISH_RAW är satt.
+#ifndef STATS_WINDOWS_MS
+#define STATS_WINDOWS_MS { 60 * 1000, 5 * 60 * 1000 }
+#endif
+#ifndef PUBLISH_RAW
+#define PUBLISH_RAW 0
+#endif
+
+// Ändringsstyrd publicering: ett meddelande skickas bara när någon kanal har rört
+// sig utanför sitt deadband (channel_bands) sedan förra publiceringen, eller när
+// det har varit tyst i DEADBAND_HEARTBEAT_MS.
+#ifndef PUBLISH_DEADBAND
+#define PUBLISH_DEADBAND 1
+#endif
+#ifndef DEADBAND_HEARTBEAT_MS
+#define DEADBAND_HEARTBEAT_MS (15 * 60 * 1000)
+#endif
+
+// Prediktiv kodning av rådatat (predict.h): per sensor skickas bara kanalerna som
+// avviker mer än sitt band från modellen som mottagaren också kör, och var
+// PREDICT_KEYFRAME_SAMPLES mätning en keyframe med alla kanaler. Kräver avkodaren
+// i tools/predict_decoder på mottagarsidan, därför avstängt som standard.
+#ifndef PUBLISH_PREDICT
+#define PUBLISH_PREDICT 0
+#endif
+#ifndef PREDICT_KEYFRAME_SAMPLES
+#define PREDICT_KEYFRAME_SAMPLES 720
+#endif
+
+// Längsta sömn i taget medan sensorerna mäter, mellan varven som servar MQTT
+#define SENSOR_IDLE_MS 10
+
+// Största payload, under sendbuf i mqtt_client.c med plats för topic och huvud
+#define PAYLOAD_LEN 1800
+
 
 
 // --- STATUS ENUM ---
@@ -50,6 +132,396 @@ NetStatus check_wifi_and_dns(const char* hostname) {
     }
 }
 
+// --- SENSORER: upp till två BME680 (0x76/0x77) per I2C-block ---
+static bme680_t sensors[BME680_MAX_SENSORS];
+static bme680_group_t sensor_group;
+
+// Senaste mätvärdet per sensor, fylls i av sensor_read_cb
+static bme680_reading_t sensor_readings[BME680_MAX_SENSORS];
+static bool sensor_ok_read[BME680_MAX_SENSORS];
+static size_t sensors_pending;
+static uint32_t sensors_triggers;
+
+// Senaste gasmätningen per sensor och löpnumret (reading.seq) den gjordes vid,
+// så att mottagaren kan para ihop gasvärdet med rätt T/H/P-mätning
+typedef struct {
+    uint32_t gas;
+    uint32_t seq;
+} gas_sample_t;
+static gas_sample_t sensor_gas[BME680_MAX_SENSORS];
+
+// Uppvärmningsdetektor per sensor, matas med gasmätningarna
+static warmup_t sensor_warmup[BME680_MAX_SENSORS];
+
+// Löpande gasbaslinje per sensor, sparas i flash och återställs efter omstart
+static gas_baseline_t sensor_baseline[BME680_MAX_SENSORS];
+
+// IAQ-index per sensor, uppdateras med varje gasmätning efter uppvärmningen
+static iaq_t sensor_iaq[BME680_MAX_SENSORS];
+
+// Statistik per fönster, sensor och kanal
+enum { CH_TEMPERATURE, CH_HUMIDITY, CH_PRESSURE, CH_GAS, CH_IAQ, CH_COUNT };
+static const char *const channel_names[CH_COUNT] = { "temperature", "humidity", "pressure", "gas", "iaq" };
+static const uint32_t stats_window_ms[] = STATS_WINDOWS_MS;
+#define STATS_WINDOW_COUNT (sizeof(stats_window_ms) / sizeof(stats_window_ms[0]))
+static stats_t sensor_stats[STATS_WINDOW_COUNT][BME680_MAX_SENSORS][CH_COUNT];
+static uint32_t stats_window_start[STATS_WINDOW_COUNT];
+
+static char payload[PAYLOAD_LEN];
+
+// Deadband per kanal, i samma enheter som statistiken
+static const deadband_band_t channel_bands[CH_COUNT] = {
+    { 10, 0 },      // 0.10 °C
+    { 1000, 0 },    // 1 %RH
+    { 50, 0 },      // 0.5 hPa
+    { 0, 50 },      // 5 % av gasresistansen
+    { 10, 0 },      // 10 IAQ-enheter
+};
+
+// Varje ström (rådata och varje statistikfönster) har egna senast publicerade värden
+#define STREAM_RAW 0
+#define STREAM_COUNT (1 + STATS_WINDOW_COUNT)
+
+typedef struct {
+    int32_t mean[CH_COUNT];
+    int32_t min[CH_COUNT];
+    int32_t max[CH_COUNT];
+    uint8_t present;        // Bit per kanal som har värden
+} channel_values_t;
+
+static deadband_ref_t publish_ref[STREAM_COUNT][BME680_MAX_SENSORS];
+static uint32_t publish_last_ms[STREAM_COUNT];
+static bool publish_started[STREAM_COUNT];
+static channel_values_t publish_values[BME680_MAX_SENSORS];  // Värdena i meddelandet som prövas
+static uint32_t publish_suppressed;
+
+// Modellen per sensor för den prediktiva kodningen. Temperatur, luftfuktighet och
+// tryck extrapoleras linjärt, gas och IAQ ändras i steg och hålls.
+#define PREDICT_LINEAR ((1u << CH_TEMPERATURE) | (1u << CH_HUMIDITY) | (1u << CH_PRESSURE))
+static predict_state_t sensor_predict[BME680_MAX_SENSORS];
+
+// --- SENSOR CALLBACK: anropas från bme680_group_task() när en sensor är klar ---
+static void sensor_read_cb(bme680_t *sensor, bool ok, const bme680_reading_t *reading, void *user_data) {
+    size_t n = (size_t)(sensor - sensors);
+
+    sensor_ok_read[n] = ok;
+    if (ok) {
+        sensor_readings[n] = *reading;
+
+        // Första mätningen: återställ sparad baslinje om den är färsk och omgivningen stämmer
+        gas_baseline_t *b = &sensor_baseline[n];
+        // Posternas ålder går bara att bedöma med NTP-tid (inte den manuella reservtiden),
+        // så återställningen prövas först när NTP har synkat
+        if (!b->restore_done) {
+            if (datetime_is_ntp_synced()) {
+                if (gas_baseline_restore(b, (uint32_t)time(NULL), reading->temperature, reading->humidity)) {
+                    printf("Sensor %u: gasbaslinje %lu ohm återställd från flash\n", (unsigned)n, (unsigned long)b->gas);
+                    warmup_set_baseline(&sensor_warmup[n], b->gas);
+                    iaq_seed(&sensor_iaq[n], b->gas, b->humidity);
+                }
+            } else if (b->valid) {
+                b->restore_done = true; // Baslinjen hann läras in före NTP-synken
+            }
+        }
+
+        if (reading->has_gas) {
+            sensor_gas[n].gas = reading->gas;
+            sensor_gas[n].seq = reading->seq;
+            if (warmup_add(&sensor_warmup[n], to_ms_since_boot(get_absolute_time()), reading->gas, reading->heat_stab)) {
+                gas_baseline_update(b, reading->gas, reading->temperature, reading->humidity);
+                iaq_update(&sensor_iaq[n], reading);
+            }
+        }
+    }
+    sensors_pending--;
+}
+
+// true när alla sensorer har passerat uppvärmningen
+static bool sensors_warm(void) {
+    for (size_t n = 0; n < sensor_group.count; n++) {
+        if (!warmup_stable(&sensor_warmup[n])) return false;
+    }
+    return true;
+}
+
+// Trigga alla sensorer. Var GAS_EVERY_CYCLES:e mätning görs med värmaren,
+// övriga bara T/H/P. Under uppvärmningen görs alla med värmaren.
+static size_t sensors_trigger(void) {
+    bool gas = sensors_triggers++ % GAS_EVERY_CYCLES == 0;
+
+    for (size_t n = 0; n < sensor_group.count; n++) sensor_ok_read[n] = false;
+    if (gas || !sensors_warm()) {
+        return bme680_group_read_async(&sensor_group, sensor_read_cb, NULL);
+    }
+    return bme680_group_read_tph_async(&sensor_group, sensor_read_cb, NULL);
+}
+
+// Leta efter sensorer på båda adresserna på båda bussarna
+static void sensors_init(void) {
+    i2c_inst_t *buses[] = { i2c0, i2c1 };
+    const uint8_t addrs[] = { BME68X_I2C_ADDR_LOW, BME68X_I2C_ADDR_HIGH };
+
+    bme680_group_init(&sensor_group);
+    bme680_bus_init(i2c0, SDA_PIN, SCL_PIN);
+    bme680_bus_init(i2c1, SDA1_PIN, SCL1_PIN);
+
+    for (size_t b = 0; b < 2; b++) {
+        for (size_t a = 0; a < 2; a++) {
+            bme680_t *sensor = &sensors[sensor_group.count];
+            if (bme680_init(sensor, buses[b], addrs[a])) {
+                printf("BME680 hittad: i2c%u 0x%02x\n", (unsigned)b, addrs[a]);
+                warmup_init(&sensor_warmup[sensor_group.count]);
+                gas_baseline_init(&sensor_baseline[sensor_group.count], (uint8_t)((b << 7) | addrs[a]));
+                iaq_init(&sensor_iaq[sensor_group.count]);
+                predict_init(&sensor_predict[sensor_group.count], CH_COUNT, PREDICT_LINEAR);
+                bme680_group_add(&sensor_group, sensor);
+                if (SENSOR_CONTINUOUS && bme680_continuous_start(sensor, SENSOR_FILTER, SENSOR_ODR)) {
+                    printf("  kontinuerligt läge\n");
+                }
+            }
+        }
+    }
+}
+
+// Skriv ett fixpunktsvärde i hundradelar som "12.34" utan att gå via flyttal
+static const char *fmt_x100(char *buf, size_t len, int32_t value_x100) {
+    uint32_t abs_value = value_x100 < 0 ? (uint32_t)(-(int64_t)value_x100) : (uint32_t)value_x100;
+    snprintf(buf, len, "%s%lu.%02lu", value_x100 < 0 ? "-" : "",
+             (unsigned long)(abs_value / 100), (unsigned long)(abs_value % 100));
+    return buf;
+}
+
+// JSON-fälten för ett mätvärde, samma format som tidigare. "gas" är senaste
+// gasmätningen och "gas_seq" löpnumret ("seq") för mätningen den gjordes i.
+// "iaq" är 0-500 och "iaq_accuracy" 0-3 (0 = ingen baslinje än, se iaq.h).
+static int fmt_reading_json(char *buf, size_t len, const bme680_reading_t *reading, const gas_sample_t *gas,
+                            const iaq_t *iaq) {
+    char temp_str[16], hum_str[16], pres_str[16];
+
+    return snprintf(buf, len, "\"temperature\": %s, \"humidity\":%s, \"pressure\":%s, \"gas\":%lu, \"seq\":%lu, \"gas_seq\":%lu, "
+                    "\"iaq\":%u, \"iaq_accuracy\":%u",
+                    fmt_x100(temp_str, sizeof(temp_str), reading->temperature),
+                    fmt_x100(hum_str, sizeof(hum_str), (int32_t)((reading->humidity + 5) / 10)),
+                    fmt_x100(pres_str, sizeof(pres_str), (int32_t)reading->pressure), // Pa = hPa x100
+                    (unsigned long)gas->gas, (unsigned long)reading->seq, (unsigned long)gas->seq,
+                    (unsigned)iaq->index, (unsigned)iaq->accuracy);
+}
+
+// Lägg en ny mätning i alla fönster. Gas och IAQ bara när mätningen gjordes med värmaren.
+static void stats_add_reading(size_t n, const bme680_reading_t *reading) {
+    for (size_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+        stats_t *ch = sensor_stats[w][n];
+        stats_add(&ch[CH_TEMPERATURE], reading->temperature);
+        stats_add(&ch[CH_HUMIDITY], (int32_t)reading->humidity);
+        stats_add(&ch[CH_PRESSURE], (int32_t)reading->pressure);
+        if (reading->has_gas) {
+            stats_add(&ch[CH_GAS], (int32_t)reading->gas);
+            if (sensor_iaq[n].accuracy > IAQ_ACCURACY_NONE) stats_add(&ch[CH_IAQ], sensor_iaq[n].index);
+        }
+    }
+}
+
+// Ett värde i kanalens publicerade enhet: °C, %RH och hPa med två decimaler, ohm och IAQ som heltal
+static const char *fmt_channel(char *buf, size_t len, size_t ch, int32_t value) {
+    switch (ch) {
+        case CH_TEMPERATURE:
+        case CH_PRESSURE: // Pa = hPa x100
+            return fmt_x100(buf, len, value);
+        case CH_HUMIDITY:
+            return fmt_x100(buf, len, (value + 5) / 10);
+        default:
+            snprintf(buf, len, "%ld", (long)value);
+            return buf;
+    }
+}
+
+// snprintf i slutet av buf. Returnerar nya längden, högst len; len betyder att texten kapades.
+static size_t appendf(char *buf, size_t len, size_t pos, const char *fmt, ...) {
+    va_list args;
+
+    if (pos >= len) return len;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + pos, len - pos, fmt, args);
+    va_end(args);
+    return n < 0 || (size_t)n >= len - pos ? len : pos + (size_t)n;
+}
+
+// Sammanfattning av ett fönster för en sensor. Medelvärdena hamnar i de vanliga
+// fälten, och med with_stats även "stats" med [n, medel, std, min, max, senaste]
+// per kanal som har värden.
+static size_t fmt_summary_json(char *buf, size_t len, size_t pos, size_t w, size_t n, bool with_stats) {
+    const stats_t *ch = sensor_stats[w][n];
+    char v[6][16];
+
+    for (size_t c = 0; c < CH_COUNT; c++) {
+        if (ch[c].n == 0) continue;
+        pos = appendf(buf, len, pos, "\"%s\":%s, ", channel_names[c],
+                      fmt_channel(v[0], sizeof(v[0]), c, stats_mean(&ch[c])));
+    }
+    pos = appendf(buf, len, pos, "\"iaq_accuracy\":%u", (unsigned)sensor_iaq[n].accuracy);
+
+    if (with_stats) {
+        pos = appendf(buf, len, pos, ", \"stats\": {");
+        bool first = true;
+        for (size_t c = 0; c < CH_COUNT; c++) {
+            if (ch[c].n == 0) continue;
+            pos = appendf(buf, len, pos, "%s\"%s\":[%lu,%s,%s,%s,%s,%s]", first ? "" : ",", channel_names[c],
+                            (unsigned long)ch[c].n,
+                            fmt_channel(v[1], sizeof(v[1]), c, stats_mean(&ch[c])),
+                            fmt_channel(v[2], sizeof(v[2]), c, (int32_t)stats_stddev(&ch[c])),
+                            fmt_channel(v[3], sizeof(v[3]), c, ch[c].min),
+                            fmt_channel(v[4], sizeof(v[4]), c, ch[c].max),
+                            fmt_channel(v[5], sizeof(v[5]), c, ch[c].last));
+            first = false;
+        }
+        pos = appendf(buf, len, pos, "}");
+    }
+    return pos;
+}
+
+// Skicka om MQTT är uppe. Returnerar true om det gick iväg. Vid fel återansluter
+// mqtt_client i bakgrunden, och mätningarna fortsätter under tiden.
+static bool publish_payload(const char *payload) {
+    if (!mqtt_connected()) {
+        printf(">> Ingen MQTT-anslutning just nu (återansluter i bakgrunden), publicerar inte.\n");
+        return false;
+    }
+    printf("Sending MQTT: %s\n", payload);
+    if(mqtt_publish(MQTT_TOPIC, payload)) {
+        printf(">> Publicering OK!\n");
+        return true;
+    }
+    printf(">> Publicering misslyckades. Återansluter i bakgrunden.\n");
+    return false;
+}
+
+// Pröva meddelandet i publish_values mot strömmens deadband. Medelvärdet, och för
+// statistikfönster även min och max, jämförs med senast publicerade medelvärdet
+// så att en kort topp inte göms av medelvärdet.
+static bool publish_due(size_t stream, size_t count, uint32_t now_ms) {
+    if (!PUBLISH_DEADBAND || !publish_started[stream] || now_ms - publish_last_ms[stream] >= DEADBAND_HEARTBEAT_MS) {
+        return true;
+    }
+    for (size_t n = 0; n < count; n++) {
+        const channel_values_t *v = &publish_values[n];
+        for (size_t c = 0; c < CH_COUNT; c++) {
+            if (!(v->present & (1u << c))) continue;
+            if (deadband_exceeded(&publish_ref[stream][n], &channel_bands[c], c, v->mean[c]) ||
+                deadband_exceeded(&publish_ref[stream][n], &channel_bands[c], c, v->min[c]) ||
+                deadband_exceeded(&publish_ref[stream][n], &channel_bands[c], c, v->max[c])) {
+                return true;
+            }
+        }
+    }
+    publish_suppressed++;
+    printf("Inga ändringar utanför deadband, publicerar inte (%lu överhoppade)\n", (unsigned long)publish_suppressed);
+    return false;
+}
+
+// Meddelandet gick iväg: dess värden blir referens för strömmen
+static void publish_commit(size_t stream, size_t count, uint32_t now_ms) {
+    for (size_t n = 0; n < count; n++) {
+        for (size_t c = 0; c < CH_COUNT; c++) {
+            if (publish_values[n].present & (1u << c)) deadband_set(&publish_ref[stream][n], c, publish_values[n].mean[c]);
+        }
+    }
+    publish_last_ms[stream] = now_ms;
+    publish_started[stream] = true;
+}
+
+static void channel_set(channel_values_t *v, size_t c, int32_t mean, int32_t min, int32_t max) {
+    v->mean[c] = mean;
+    v->min[c] = min;
+    v->max[c] = max;
+    v->present |= (uint8_t)(1u << c);
+}
+
+// Rådatat för sensor n per kanal, i samma enheter som fmt_reading_json()
+static void reading_values(const bme680_reading_t *reading, size_t n, int32_t *value) {
+    value[CH_TEMPERATURE] = reading->temperature;
+    value[CH_HUMIDITY] = (int32_t)reading->humidity;
+    value[CH_PRESSURE] = (int32_t)reading->pressure;
+    value[CH_GAS] = (int32_t)sensor_gas[n].gas;
+    value[CH_IAQ] = sensor_iaq[n].index;
+}
+
+// Rådata: värdena som fmt_reading_json() skickar
+static bool raw_due(const bme680_reading_t *readings, size_t count, uint32_t now_ms) {
+    for (size_t n = 0; n < count; n++) {
+        channel_values_t *v = &publish_values[n];
+        int32_t value[CH_COUNT];
+
+        reading_values(&readings[n], n, value);
+        v->present = 0;
+        for (size_t c = 0; c < CH_COUNT; c++) {
+            if (c == CH_GAS && sensor_gas[n].gas == 0) continue;
+            if (c == CH_IAQ && sensor_iaq[n].accuracy == IAQ_ACCURACY_NONE) continue;
+            channel_set(v, c, value[c], value[c], value[c]);
+        }
+    }
+    return publish_due(STREAM_RAW, count, now_ms);
+}
+
+// Statistikfönster w: medelvärde, min och max per kanal
+static bool window_due(size_t w, size_t count, uint32_t now_ms) {
+    for (size_t n = 0; n < count; n++) {
+        channel_values_t *v = &publish_values[n];
+
+        v->present = 0;
+        for (size_t c = 0; c < CH_COUNT; c++) {
+            const stats_t *s = &sensor_stats[w][n][c];
+            if (s->n > 0) channel_set(v, c, stats_mean(s), s->min, s->max);
+        }
+    }
+    return publish_due(1 + w, count, now_ms);
+}
+
+// Prediktivt kodat rådata: {"connected": true, "pc": [...]} med ett meddelande per
+// sensor som har något att skicka (se predict_fmt_json). Modellerna uppdateras
+// bara när publiceringen gick iväg, så att de följer det mottagaren har fått.
+static void publish_predicted(const bme680_reading_t *readings, size_t count) {
+    int32_t values[BME680_MAX_SENSORS][CH_COUNT];
+    uint32_t mask[BME680_MAX_SENSORS] = { 0 };
+    bool key[BME680_MAX_SENSORS] = { false };
+    bool any = false;
+    size_t pos = appendf(payload, sizeof(payload), 0, "{\"connected\": true, \"pc\": [");
+
+    for (size_t n = 0; n < count; n++) {
+        const bme680_t *s = sensor_group.sensors[n];
+        char id[16];
+
+        if (readings[n].seq == 0) continue; // Ingen ny mätning
+        reading_values(&readings[n], n, values[n]);
+        key[n] = predict_keyframe_due(&sensor_predict[n], readings[n].seq, PREDICT_KEYFRAME_SAMPLES);
+        mask[n] = predict_check(&sensor_predict[n], readings[n].seq, values[n], channel_bands);
+        if (!key[n] && !mask[n]) continue;
+
+        snprintf(id, sizeof(id), "i2c%u-%02x", (unsigned)i2c_hw_index(s->i2c), s->addr);
+        if (any) pos = appendf(payload, sizeof(payload), pos, ", ");
+        if (pos < sizeof(payload)) {
+            int len = predict_fmt_json(payload + pos, sizeof(payload) - pos, id, &sensor_predict[n],
+                                       readings[n].seq, values[n], mask[n], key[n], channel_names);
+            pos = len < 0 || (size_t)len >= sizeof(payload) - pos ? sizeof(payload) : pos + (size_t)len;
+        }
+        any = true;
+    }
+    if (!any) {
+        publish_suppressed++;
+        printf("Alla värden inom prediktionen, publicerar inte (%lu överhoppade)\n", (unsigned long)publish_suppressed);
+        return;
+    }
+    pos = appendf(payload, sizeof(payload), pos, "]}");
+    if (pos >= sizeof(payload)) {
+        printf("Prediktionsmeddelandet fick inte plats i %u bytes\n", (unsigned)sizeof(payload));
+        return;
+    }
+    if (!publish_payload(payload)) return;
+
+    for (size_t n = 0; n < count; n++) {
+        if (key[n] || mask[n]) predict_apply(&sensor_predict[n], readings[n].seq, values[n], mask[n], key[n]);
+    }
+}
+
 void print_pico_time() {
     time_t now;
     time(&now);
@@ -129,12 +601,7 @@ int main() {
 
     switch (status) {
         case NET_OK:
-            printf("[STATUS] Nätverk & DNS OK. Försöker starta MQTT...\n");
-            if (mqtt_init()) {
-                printf("MQTT Initialized & Connected!\n");
-            } else {
-                printf("MQTT Init Failed (TLS Error).\n");
-            }
+            printf("[STATUS] Nätverk & DNS OK.\n");
             break;
 
         case NET_ERR_WIFI_DOWN:
@@ -150,78 +617,177 @@ int main() {
             break;
     }
 
-    // Initiera Sensor
-    i2c_init(i2c0, 100 * 1000);
-    gpio_set_function(SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(SDA_PIN);
-    gpio_pull_up(SCL_PIN);
+    // Uppkopplingen (DNS, TLS, CONNECT) sker i bakgrunden medan vi mäter, och
+    // görs om med backoff om länken eller servern försvinner
+    printf("Startar MQTT i bakgrunden...\n");
+    mqtt_init();
 
+    // Initiera sensorerna (bme680_bus_init sätter upp I2C, pinnar och DMA)
     printf("Initializing BME680...\n");
-    bool sensor_ok = bme680_init(i2c0, SDA_PIN, SCL_PIN);
+    sensors_init();
+    bool sensor_ok = sensor_group.count > 0;
     if (!sensor_ok) printf("VARNING: BME680 hittades inte.\n");
 
-    const uint32_t WARMUP_TIME_MS = 30 * 60 * 1000;
     uint32_t start_time = to_ms_since_boot(get_absolute_time());
     bool sending_activate = false;
+    uint32_t cycle = 0;
+    bool sensors_triggered = false;     // Mätningen för nästa cykel är redan igång (pipeline)
+    absolute_time_t next_cycle = get_absolute_time();
 
-    printf("Startar mtning. Data skickas till Yggio om %d minuter.\n", 30);
+    printf("Startar mätning. Data skickas till Yggio när sensorerna är stabila, senast om %d minuter.\n", WARMUP_MAX_MS / 60000);
 
 
     // Huvudloop
     while (1) {
 
-        float temp = 0, hum = 0, pres = 0, gas = 0;
+        // Fixpunkt hela vägen: °C x100, % x1000, Pa och ohm
+        bme680_reading_t readings[BME680_MAX_SENSORS] = {0};
+        size_t n_readings = sensor_group.count;
+        char temp_str[16], hum_str[16];
 
         if (sensor_ok) {
-            bme680_read(&temp, &hum, &pres, &gas);
-	    printf("SENSOR: Temp: %.2f C, Hum: %.2f %%, Pres: %.0f hPa, Gas: %.0f Ohm\n", temp, hum, pres, gas);
+            // Trigga alla sensorer samtidigt (om pipelinen inte redan gjort det)
+            // och serva MQTT medan de mäter och DMA läser
+            if (!sensors_triggered) sensors_pending = sensors_trigger();
+            while (sensors_pending > 0) {
+                bme680_group_task(&sensor_group);
+                if (sensors_pending > 0) {
+                    mqtt_loop();
+                    // Sov tills nästa avbrott (larm, I2C/DMA, lwIP), högst SENSOR_IDLE_MS
+                    best_effort_wfe_or_timeout(make_timeout_time_ms(SENSOR_IDLE_MS));
+                }
+            }
+            for (size_t n = 0; n < n_readings; n++) {
+                if (sensor_ok_read[n]) {
+                    readings[n] = sensor_readings[n];
+                    stats_add_reading(n, &readings[n]);
+                }
+            }
+
+            // Pipeline: nästa mätning går medan vi formaterar, skickar och sover
+            sensors_triggered = false;
+            if (SENSOR_PIPELINE) {
+                sensors_pending = sensors_trigger();
+                sensors_triggered = sensors_pending > 0;
+            }
+
+            for (size_t n = 0; n < n_readings; n++) {
+                printf("SENSOR %u: #%lu Temp: %s C, Hum: %s %%, Pres: %lu hPa, Gas: %lu Ohm från #%lu (I2C sparade: %lu)\n",
+                       (unsigned)n, (unsigned long)readings[n].seq,
+                       fmt_x100(temp_str, sizeof(temp_str), readings[n].temperature),
+                       fmt_x100(hum_str, sizeof(hum_str), (int32_t)((readings[n].humidity + 5) / 10)),
+                       (unsigned long)((readings[n].pressure + 50) / 100),
+                       (unsigned long)sensor_gas[n].gas, (unsigned long)sensor_gas[n].seq,
+                       (unsigned long)bme680_saved_transfers(sensor_group.sensors[n]));
+            }
         } else {
             printf("SIMULERING: Skapar fejk-data...\n");
-            temp = 20.5f; hum = 50.0f; pres = 1013.0f; gas = 1000.0f;
+            n_readings = 1;
+            readings[0].temperature = 2050; readings[0].humidity = 50000; readings[0].pressure = 101300; readings[0].gas = 1000;
+            sensor_gas[0].gas = 1000;
+            stats_add_reading(0, &readings[0]);
+        }
+
+        // Inlärd mättid och latenshistogram ungefär var femte minut
+        if (sensor_ok && ++cycle % TIMING_REPORT_CYCLES == 0) {
+            for (size_t n = 0; n < sensor_group.count; n++) bme680_print_timing(sensor_group.sensors[n]);
+        }
+
+        // Spara gasbaslinjerna med jämna mellanrum (bara med NTP-tid, annars går åldern inte att bedöma)
+        if (sensor_ok && datetime_is_ntp_synced()) {
+            for (size_t n = 0; n < sensor_group.count; n++) {
+                if (gas_baseline_save(&sensor_baseline[n], to_ms_since_boot(get_absolute_time()), (uint32_t)time(NULL))) {
+                    printf("Sensor %u: gasbaslinje %lu ohm sparad\n", (unsigned)n, (unsigned long)sensor_baseline[n].gas);
+                }
+            }
         }
 
 	if (!sending_activate){
-		uint32_t current_time = to_ms_since_boot(get_absolute_time());
+		uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - start_time;
 
-		if ((current_time - start_time) > WARMUP_TIME_MS){
+		if (sensors_warm()){
+			sending_activate = true;
+			printf("\n--- Sensorerna är stabila efter %lu sekunder! Skickar data till Yggio nu. ---\n", (unsigned long)(elapsed / 1000));
+		} else if (elapsed > WARMUP_MAX_MS){
 			sending_activate = true;
-			printf("\n--- 30 minuter har passerat! Skickar data till Yggio nu. ---\n");
+			printf("\n--- %d minuter har passerat! Skickar data till Yggio nu. ---\n", WARMUP_MAX_MS / 60000);
 		} else{
-			uint32_t elapsed = current_time - start_time;
-			uint32_t remaining = WARMUP_TIME_MS - elapsed;
-			printf("...Skickat data om ca %d sekunder.\n", remaining/1000);
+			for (size_t n = 0; n < sensor_group.count; n++) {
+				const warmup_t *w = &sensor_warmup[n];
+				printf("...Uppvärmning sensor %u: %u/%u mätningar, spridning %lu, lutning %lu promille/min\n",
+				       (unsigned)n, w->count, WARMUP_WINDOW,
+				       (unsigned long)w->stddev_permille, (unsigned long)w->slope_permille);
+			}
+			printf("...Skickar data senast om ca %lu sekunder.\n", (unsigned long)((WARMUP_MAX_MS - elapsed) / 1000));
 		}
 	}
 
-	if (sending_activate){
-		char payload[256];
-        	snprintf(payload, sizeof(payload), 
-				"{\"connected\": true, \"temperature\": %.2f, \"humidity\":%.2f, \"pressure\":%.2f, \"gas\":%.2f}", 
-				temp, hum, pres, gas);
-
-        	printf("Sending MQTT: %s\n", payload);
-        	if(mqtt_publish(MQTT_TOPIC, payload)) {
-             		printf(">> Publicering OK!\n");
-        	} else {
-             		printf(">> Publicering misslyckades.\n");
-	    		printf(">> Frsker teransluta..\n");
-
-	     		if (mqtt_init()){
-				printf(">> återansluten frsker skicka igen..\n");
-
-		     		if (mqtt_publish(MQTT_TOPIC, payload)){
-			     		printf(">> Publicering OK (efter reconnect)!\n");
-				}
-			} else {
-		     		printf(">> Kunde inte teransluta just nu. Frsker nsta varv.\n");
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+
+	if (sending_activate && PUBLISH_RAW && raw_due(readings, n_readings, now_ms)){
+		// Första sensorn i de gamla fälten, alla sensorer i "sensors" när det finns fler
+		size_t pos = 0;
+		pos += snprintf(payload, sizeof(payload), "{\"connected\": true, ");
+		pos += fmt_reading_json(payload + pos, sizeof(payload) - pos, &readings[0], &sensor_gas[0], &sensor_iaq[0]);
+		if (n_readings > 1) {
+			pos += snprintf(payload + pos, sizeof(payload) - pos, ", \"sensors\": [");
+			for (size_t n = 0; n < n_readings; n++) {
+				const bme680_t *s = sensor_group.sensors[n];
+				pos += snprintf(payload + pos, sizeof(payload) - pos, "%s{\"id\": \"i2c%u-%02x\", ",
+						n ? ", " : "", (unsigned)i2c_hw_index(s->i2c), s->addr);
+				pos += fmt_reading_json(payload + pos, sizeof(payload) - pos, &readings[n], &sensor_gas[n], &sensor_iaq[n]);
+				pos += snprintf(payload + pos, sizeof(payload) - pos, "}");
 			}
+			pos += snprintf(payload + pos, sizeof(payload) - pos, "]");
 		}
+		snprintf(payload + pos, sizeof(payload) - pos, "}");
+		if (publish_payload(payload)) publish_commit(STREAM_RAW, n_readings, now_ms);
 	}
 
+        if (sending_activate && PUBLISH_PREDICT) publish_predicted(readings, n_readings);
+
+        // Stängda statistikfönster: publicera sammanfattningen (om något har ändrats) och börja om
+        for (size_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+            if (now_ms - stats_window_start[w] < stats_window_ms[w]) continue;
+
+            if (sending_activate && sensor_stats[w][0][CH_TEMPERATURE].n > 0 && window_due(w, n_readings, now_ms)) {
+                // Samma upplägg som rådatat: första sensorn i de vanliga fälten, alla i "sensors"
+                size_t pos = appendf(payload, sizeof(payload), 0, "{\"connected\": true, \"window\": %lu, ",
+                                     (unsigned long)(stats_window_ms[w] / 1000));
+                pos = fmt_summary_json(payload, sizeof(payload), pos, w, 0, n_readings == 1);
+                if (n_readings > 1) {
+                    pos = appendf(payload, sizeof(payload), pos, ", \"sensors\": [");
+                    for (size_t n = 0; n < n_readings; n++) {
+                        const bme680_t *s = sensor_group.sensors[n];
+                        pos = appendf(payload, sizeof(payload), pos, "%s{\"id\": \"i2c%u-%02x\", ",
+                                      n ? ", " : "", (unsigned)i2c_hw_index(s->i2c), s->addr);
+                        pos = fmt_summary_json(payload, sizeof(payload), pos, w, n, true);
+                        pos = appendf(payload, sizeof(payload), pos, "}");
+                    }
+                    pos = appendf(payload, sizeof(payload), pos, "]");
+                }
+                pos = appendf(payload, sizeof(payload), pos, "}");
+                if (pos < sizeof(payload)) {
+                    if (publish_payload(payload)) publish_commit(1 + w, n_readings, now_ms);
+                } else {
+                    printf("Sammanfattningen fick inte plats i %u bytes\n", (unsigned)sizeof(payload));
+                }
+            }
+
+            for (size_t n = 0; n < BME680_MAX_SENSORS; n++) {
+                for (size_t c = 0; c < CH_COUNT; c++) stats_reset(&sensor_stats[w][n][c]);
+            }
+            stats_window_start[w] = now_ms;
+        }
+
         mqtt_loop(); 
-        printf("Waiting 5s...\n\n");
-        sleep_ms(5000);
+
+        // Fast takt: sov bara det som är kvar av intervallet, arbetet ovan räknas in
+        next_cycle = delayed_by_ms(next_cycle, SAMPLE_INTERVAL_MS);
+        if (absolute_time_diff_us(get_absolute_time(), next_cycle) < 0) next_cycle = get_absolute_time();
+        printf("Waiting %lld ms...\n\n", (long long)(absolute_time_diff_us(get_absolute_time(), next_cycle) / 1000));
+        // Sov till nästa cykel men driv MQTT (uppkoppling, CONNACK, keepalive) vid varje avbrott
+        while (!best_effort_wfe_or_timeout(next_cycle)) mqtt_loop();
     }
 
     return 0;
@@ -28,41 +28,55 @@ static Network network; // VIKTIGT: Måste vara static/global så den lever kvar
 static unsigned char sendbuf[2048]; // Buffertar för MQTT (öka om du skickar stor data)
 static unsigned char readbuf[2048];
 
-bool mqtt_publish(const char* topic, const char* payload);
+// Längsta tid mqtt_loop() väntar på resten av trafiken när något har kommit
+#define MQTT_YIELD_MS 20
 
-// ==========================================
-// INITIERING
-// ==========================================
+// Uppkopplingen är en tillståndsmaskin som mqtt_loop() driver framåt, så main
+// fortsätter mäta medan DNS, TLS och CONNECT pågår. Varje fas har en egen timeout,
+// och efter ett misslyckande väntar vi med exponentiell backoff.
+#define MQTT_RESOLVE_TIMEOUT_MS 10000
+#define MQTT_TLS_TIMEOUT_MS 30000       // TCP + handskakning, mbedTLS på M0+ tar flera sekunder
+#define MQTT_CONNACK_TIMEOUT_MS 10000
+#define MQTT_BACKOFF_MIN_MS 2000
+#define MQTT_BACKOFF_MAX_MS 60000
 
-bool mqtt_init() {
-    // Notera: Vi initierar INTE Wi-Fi här. Det görs i main.c.
-    // Vi antar att nätverket redan är uppe.
-    printf("\n=== RÖNTGEN-CHECK AV NYCKEL ===\n");
-    int len = strlen(client_key);
+typedef enum {
+    MQTT_STATE_IDLE,        // mqtt_init() inte anropad
+    MQTT_STATE_BACKOFF,     // Väntar till nästa försök (eller på Wi-Fi-länken)
+    MQTT_STATE_RESOLVING,   // DNS
+    MQTT_STATE_TLS,         // TCP-anslutning och TLS-handskakning
+    MQTT_STATE_CONNACK,     // CONNECT skickat, väntar på CONNACK
+    MQTT_STATE_UP,
+} mqtt_state_t;
 
-    // Vi tittar på de sista 8 tecknen
-    printf("Totallängd: %d\n", len);
-    printf("De sista tecknen (ASCII-koder):\n");
+static const char *const state_names[] = { "idle", "backoff", "dns", "tls", "connack", "up" };
 
-    for (int i = len - 8; i <= len; i++) {
-        char c = client_key[i];
-        if (c == '\0') printf("Position %d: [NULL] (Slutet)\n", i);
-        else if (c == '\n') printf("Position %d: [10] (Radbrytning - RÄTT!)\n", i);
-        else if (c == '\r') printf("Position %d: [13] (Carriage Return - FEL!)\n", i);
-        else printf("Position %d: [%d] '%c'\n", i, c, c);
-    }
-    printf("===============================\n");
+static mqtt_state_t mqtt_state = MQTT_STATE_IDLE;
+static uint32_t state_deadline;         // ms sedan boot då fasen ger upp (backoff: nästa försök)
+static uint32_t backoff_ms = MQTT_BACKOFF_MIN_MS;
 
-    printf("Setting up MQTT connection to %s:%d...\n", MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+bool mqtt_publish(const char* topic, const char* payload);
 
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
 
-    // 1. Starta TLS-koppling (Använder certifikaten ovan)
-    TLSConnect(&network, MQTT_BROKER_HOST, MQTT_BROKER_PORT, ca_cert, client_cert, client_key);
-    
-    // 2. Initiera Paho MQTT-klienten
-    MQTTClientInit(&client, &network, 30000, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+static void enter_state(mqtt_state_t state, uint32_t timeout_ms) {
+    mqtt_state = state;
+    state_deadline = now_ms() + timeout_ms;
+}
 
-    // 3. Konfigurera inloggningsdata
+// Stäng kopplingen och försök igen efter backoff_ms, som dubblas för varje misslyckande i rad
+static void mqtt_fail(const char *reason) {
+    printf("MQTT: %s i fasen %s, nytt försök om %lu s\n", reason, state_names[mqtt_state],
+           (unsigned long)(backoff_ms / 1000));
+    client.isconnected = 0;
+    TLSClose(&network);
+    enter_state(MQTT_STATE_BACKOFF, backoff_ms);
+    backoff_ms = backoff_ms * 2 > MQTT_BACKOFF_MAX_MS ? MQTT_BACKOFF_MAX_MS : backoff_ms * 2;
+}
+
+static MQTTPacket_connectData connect_data(void) {
     MQTTPacket_connectData connectData = MQTTPacket_connectData_initializer;
     connectData.MQTTVersion = 4;
     connectData.clientID.cstring = MQTT_CLIENT_ID;
@@ -74,27 +88,149 @@ bool mqtt_init() {
     connectData.will.message.cstring = "{\"connected\": false";
     connectData.will.qos = 1;
     connectData.will.retained = 0;
+    return connectData;
+}
+
+// Skicka CONNECT utan att vänta på svaret (MQTTConnect() blockerar tills CONNACK)
+static bool send_connect(void) {
+    MQTTPacket_connectData connectData = connect_data();
+    int len = MQTTSerialize_connect(sendbuf, sizeof(sendbuf), &connectData);
 
-    // 4. Anslut till mäklaren (Broker)
     printf("Sending MQTT Connect packet...\n");
-    int rc = MQTTConnect(&client, &connectData);
-    
-    if (rc != 0) {
-        printf("MQTT connection failed with return code: %d\n", rc);
+    return len > 0 && network.mqttwrite(&network, sendbuf, len, 0) == len;
+}
+
+// CONNACK (4 bytes) ligger i mottagningsringen. Ställ klienten i samma läge som
+// MQTTConnect() gör efter ett lyckat svar.
+static bool read_connack(void) {
+    MQTTPacket_connectData connectData = connect_data();
+    unsigned char session_present = 0, connack_rc = 255;
+
+    if (network.mqttread(&network, readbuf, 4, 0) != 4 ||
+        MQTTDeserialize_connack(&session_present, &connack_rc, readbuf, 4) != 1) {
+        return false;
+    }
+    if (connack_rc != 0) {
+        printf("MQTT connection failed with return code: %d\n", connack_rc);
         return false;
     }
 
-    //mqtt_publish(MQTT_TOPIC, "");
+    client.keepAliveInterval = connectData.keepAliveInterval;
+    client.cleansession = connectData.cleansession;
+    client.ping_outstanding = 0;
+    client.isconnected = 1;
+    TimerCountdown(&client.last_sent, client.keepAliveInterval);
+    TimerCountdown(&client.last_received, client.keepAliveInterval);
+    return true;
+}
+
+// Ett steg i tillståndsmaskinen. Blockerar aldrig.
+static void mqtt_step(void) {
+    uint32_t now = now_ms();
+    bool expired = (int32_t)(now - state_deadline) >= 0;
+
+    switch (mqtt_state) {
+        case MQTT_STATE_IDLE:
+        case MQTT_STATE_UP:
+            return;
+
+        case MQTT_STATE_BACKOFF:
+            if (!expired) return;
+            // Utan länk är det ingen idé att slå upp något, titta igen om en stund utan att öka backoff
+            if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP) {
+                enter_state(MQTT_STATE_BACKOFF, MQTT_BACKOFF_MIN_MS);
+                return;
+            }
+            printf("Setting up MQTT connection to %s:%d...\n", MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+            // 1. Starta TLS-koppling (Använder certifikaten ovan)
+            if (!TLSConnectStart(&network, MQTT_BROKER_HOST, MQTT_BROKER_PORT, ca_cert, client_cert, client_key)) {
+                mqtt_fail("TLS kunde inte startas");
+                return;
+            }
+            // 2. Initiera Paho MQTT-klienten
+            MQTTClientInit(&client, &network, 30000, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+            enter_state(MQTT_STATE_RESOLVING, MQTT_RESOLVE_TIMEOUT_MS);
+            return;
+
+        case MQTT_STATE_RESOLVING:
+        case MQTT_STATE_TLS:
+            switch (TLSConnectState(&network)) {
+                case TLS_STATE_CONNECTING:
+                    if (mqtt_state == MQTT_STATE_RESOLVING) enter_state(MQTT_STATE_TLS, MQTT_TLS_TIMEOUT_MS);
+                    else if (expired) mqtt_fail("timeout");
+                    return;
+                case TLS_STATE_CONNECTED:
+                    // 3. Anslut till mäklaren (Broker)
+                    if (send_connect()) {
+                        enter_state(MQTT_STATE_CONNACK, MQTT_CONNACK_TIMEOUT_MS);
+                    } else {
+                        mqtt_fail("CONNECT kunde inte skickas");
+                    }
+                    return;
+                case TLS_STATE_RESOLVING:
+                    if (expired) mqtt_fail("timeout");
+                    return;
+                default:
+                    mqtt_fail("anslutningen misslyckades");
+                    return;
+            }
+
+        case MQTT_STATE_CONNACK:
+            if (TLSConnectState(&network) != TLS_STATE_CONNECTED) {
+                mqtt_fail("kopplingen stängdes");
+            } else if (TLSAvailable(&network) >= 4) {
+                if (!read_connack()) {
+                    mqtt_fail("CONNACK nekad eller felaktig");
+                    return;
+                }
+                mqtt_state = MQTT_STATE_UP;
+                backoff_ms = MQTT_BACKOFF_MIN_MS;
+                if(!mqtt_publish(MQTT_STATUS_TOPIC,"{\"connected\": true}")){
+                    printf("VARNING: Kunde inte skicka true-statusmeddelande. \n");
+                }
+                printf("MQTT connected successfully!\n");
+            } else if (expired) {
+                mqtt_fail("timeout");
+            }
+            return;
+    }
+}
+
+// ==========================================
+// INITIERING
+// ==========================================
+
+// Startar uppkopplingen i bakgrunden, mqtt_loop() driver den vidare.
+// Returnerar false bara om klienten redan är igång.
+bool mqtt_init() {
+    // Notera: Vi initierar INTE Wi-Fi här. Det görs i main.c.
+    if (mqtt_state != MQTT_STATE_IDLE) return false;
+
+    printf("\n=== RÖNTGEN-CHECK AV NYCKEL ===\n");
+    int len = strlen(client_key);
 
+    // Vi tittar på de sista 8 tecknen
+    printf("Totallängd: %d\n", len);
+    printf("De sista tecknen (ASCII-koder):\n");
 
-    if(!mqtt_publish(MQTT_STATUS_TOPIC,"{\"connected\": true}")){
-	    printf("VARNING: Kunde inte skicka true-statusmeddelande. \n");
+    for (int i = len - 8; i <= len; i++) {
+        char c = client_key[i];
+        if (c == '\0') printf("Position %d: [NULL] (Slutet)\n", i);
+        else if (c == '\n') printf("Position %d: [10] (Radbrytning - RÄTT!)\n", i);
+        else if (c == '\r') printf("Position %d: [13] (Carriage Return - FEL!)\n", i);
+        else printf("Position %d: [%d] '%c'\n", i, c, c);
     }
+    printf("===============================\n");
 
-    printf("MQTT connected successfully!\n");
+    enter_state(MQTT_STATE_BACKOFF, 0);
+    mqtt_step();
     return true;
 }
 
+bool mqtt_connected(void) {
+    return mqtt_state == MQTT_STATE_UP;
+}
+
 // ==========================================
 // PUBLICERA
 // ==========================================
@@ -102,6 +238,8 @@ bool mqtt_init() {
 bool mqtt_publish(const char* topic, const char* payload) {
     MQTTMessage message;
     memset(&message, 0, sizeof(message));
+
+    if (mqtt_state != MQTT_STATE_UP) return false;
     
     message.qos = QOS0;
     message.retained = 0;
@@ -112,6 +250,7 @@ bool mqtt_publish(const char* topic, const char* payload) {
     
     if (rc != 0) {
         printf("Failed to publish, return code: %d\n", rc);
+        mqtt_fail("publiceringen misslyckades");
         return false;
     }
     return true;
@@ -121,10 +260,19 @@ bool mqtt_publish(const char* topic, const char* payload) {
 // LOOP (Håll vid liv)
 // ==========================================
 
-void mqtt_loop() {
+bool mqtt_loop(void) {
     // Denna måste anropas regelbundet i main-loopen
-    // för att skicka "ping" till servern och ta emot data.
-    if (client.isconnected) {
-        MQTTYield(&client, 100); // Vänta max 100ms på trafik
+    // för att driva uppkopplingen, skicka "ping" till servern och ta emot data.
+    // Utan mottagen data görs bara keepalive-kontrollen (timeout 0), så anropet
+    // kostar inget medan main väntar på sensorerna. Har något kommit läses det,
+    // och Yield sover sedan i paho_read tills MQTT_YIELD_MS har gått.
+    mqtt_step();
+    if (mqtt_state != MQTT_STATE_UP) return false;
+
+    if (TLSConnectState(&network) != TLS_STATE_CONNECTED || !client.isconnected ||
+        MQTTYield(&client, TLSAvailable(&network) > 0 ? MQTT_YIELD_MS : 0) != SUCCESS) {
+        mqtt_fail("kopplingen tappades");
+        return false;
     }
+    return true;
 }
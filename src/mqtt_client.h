@@ -4,7 +4,11 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// mqtt_init() startar uppkopplingen i bakgrunden och mqtt_loop() driver den
+// (DNS, TLS, CONNECT, CONNACK och återanslutning med backoff). Inget av anropen
+// blockerar i väntan på nätverket.
 bool mqtt_init(void);
+bool mqtt_connected(void);
 bool mqtt_publish(const char* topic, const char* payload);
 bool mqtt_loop(void);
 
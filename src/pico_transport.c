@@ -8,7 +8,9 @@
 #include "lwip/dns.h"
 #include "hardware/structs/rosc.h"
 #include "hardware/regs/rosc.h"
+#include "hardware/sync.h"
 #include "mbedtls/ssl.h"
+#include <string.h>
 
 /* ==========================================
  * 1. TIMER IMPLEMENTATION (Oförändrad)
@@ -43,52 +45,112 @@ int TimerLeftMS(Timer* timer) {
  * 2. NETWORK / TLS IMPLEMENTATION
  * ========================================== */
 
+// Mottagna klartextbytes som Paho inte har läst än. Rymmer ett MQTT-paket av
+// readbuf-storlek (mqtt_client.c). Det som inte får plats ligger kvar i pbuf-kedjan
+// rx_chain. TCP-fönstret kvitteras (altcp_recved) först när Paho har läst bytesen,
+// så en långsam läsare stryper servern i stället för att data kastas.
+#define TLS_RX_RING_LEN 2048    // Tvåpotens
+
 // Intern struktur för att hantera lwIP-kopplingens status
 typedef struct TLSContext {
     struct altcp_pcb *pcb;
     bool connected;
-    bool busy;
-    unsigned char *buffer;
-    int buffer_len;
-    int buffer_pos;
+    volatile TLSState state;    // Ändras i lwIP-callbacks
+    u16_t port;
+    unsigned char rx_ring[TLS_RX_RING_LEN];
+    uint32_t rx_head;           // Skrivs i lwIP-kontext (tls_recv)
+    uint32_t rx_tail;           // Läses av paho_read, båda räknar fritt
+    struct pbuf *rx_chain;      // Mottaget som inte fått plats i ringen
 } TLSContext;
 
 static TLSContext g_ctx = {0}; // Vi använder en global kontext för enkelhetens skull
 
+// Flytta så mycket som får plats från pbuf-kedjan till ringen. lwIP-kontext eller lwIP-låset.
+static void rx_fill(TLSContext *ctx) {
+    while (ctx->rx_chain) {
+        uint32_t free = TLS_RX_RING_LEN - (ctx->rx_head - ctx->rx_tail);
+        uint32_t pos = ctx->rx_head & (TLS_RX_RING_LEN - 1);
+        uint32_t n = TLS_RX_RING_LEN - pos; // Sammanhängande fram till slutet av ringen
+
+        if (free == 0) break;
+        if (n > free) n = free;
+        if (n > ctx->rx_chain->tot_len) n = ctx->rx_chain->tot_len;
+        pbuf_copy_partial(ctx->rx_chain, ctx->rx_ring + pos, (u16_t)n, 0);
+        ctx->rx_head += n;
+        ctx->rx_chain = pbuf_free_header(ctx->rx_chain, (u16_t)n);
+    }
+}
+
+// Läs upp till len bytes ur ringen och kvittera dem mot TCP-fönstret. Håll lwIP-låset.
+static int rx_take(TLSContext *ctx, unsigned char *dst, int len) {
+    int got = 0;
+
+    while (got < len) {
+        rx_fill(ctx);
+        uint32_t used = ctx->rx_head - ctx->rx_tail;
+        uint32_t pos = ctx->rx_tail & (TLS_RX_RING_LEN - 1);
+        uint32_t n = TLS_RX_RING_LEN - pos;
+
+        if (used == 0) break;
+        if (n > used) n = used;
+        if (n > (uint32_t)(len - got)) n = (uint32_t)(len - got);
+        memcpy(dst + got, ctx->rx_ring + pos, n);
+        ctx->rx_tail += n;
+        got += (int)n;
+    }
+    // Paho läser högst readbuf åt gången, så got ryms i u16_t
+    if (got > 0 && ctx->pcb) altcp_recved(ctx->pcb, (u16_t)got);
+    return got;
+}
+
+// Töm ringen och släpp det som ligger kvar i kedjan, inför en ny koppling
+static void rx_reset(TLSContext *ctx) {
+    if (ctx->rx_chain) pbuf_free(ctx->rx_chain);
+    ctx->rx_chain = NULL;
+    ctx->rx_head = 0;
+    ctx->rx_tail = 0;
+}
+
+// Alla callbacks nedan körs i lwIP:s bakgrundsavbrott och avslutar med __sev(),
+// som väcker paho_read/paho_write ur __wfe() (samma mönster som i2c_dma.c).
+
 // Callback: När fel uppstår (t.ex. nedkoppling)
 static void tls_err(void *arg, err_t err) {
     TLSContext *ctx = (TLSContext*)arg;
     if (ctx) {
         printf("TLS Error: %d\n", err);
         ctx->connected = false;
-        ctx->pcb = NULL;
+        ctx->pcb = NULL; // lwIP har redan frigjort den
+        ctx->state = TLS_STATE_FAILED;
     }
+    __sev();
 }
 
-// Callback: När data tas emot från servern
+// Callback: När data tas emot från servern. Allt behålls: det som får plats går
+// till ringen och resten köas i rx_chain. Kvitteringen görs i rx_take().
 static err_t tls_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err) {
     TLSContext *ctx = (TLSContext*)arg;
     if (!p) {
-        // NULL pbuf betyder att servern stängde kopplingen
+        // NULL pbuf betyder att servern stängde kopplingen. Det som redan tagits emot kan fortfarande läsas.
         ctx->connected = false;
+        ctx->state = TLS_STATE_FAILED;
+        __sev();
         return ERR_OK;
     }
 
-    if (p->tot_len > 0) {
-        // Vi har fått data, men Paho är inte redo att läsa den än (synkront vs asynkront).
-        // I en enkel lösning: Vi kan inte buffra allt här utan minnesläckor.
-        // Paho Embedded C är designat för att polla.
-        
-        // För denna lösning kopierar vi data till vår interna buffer om det finns plats.
-        // OBS: Detta är förenklat. I produktion bör man ha en ringbuffer.
-        if (ctx->buffer && ctx->buffer_len > 0) {
-            int copy_len = (p->tot_len > ctx->buffer_len) ? ctx->buffer_len : p->tot_len;
-            pbuf_copy_partial(p, ctx->buffer, copy_len, 0);
-            ctx->buffer_pos = copy_len; // Markera hur mycket vi läste
-            altcp_recved(pcb, p->tot_len); // Säg till lwIP att vi tagit emot datan
-        }
+    if (ctx->rx_chain) {
+        pbuf_cat(ctx->rx_chain, p);
+    } else {
+        ctx->rx_chain = p;
     }
-    pbuf_free(p);
+    rx_fill(ctx);
+    __sev();
+    return ERR_OK;
+}
+
+// Callback: Servern har kvitterat skickad data, det finns plats i sändbufferten igen
+static err_t tls_sent(void *arg, struct altcp_pcb *pcb, u16_t len) {
+    __sev();
     return ERR_OK;
 }
 
@@ -98,108 +160,139 @@ static err_t tls_connected(void *arg, struct altcp_pcb *pcb, err_t err) {
     if (err == ERR_OK) {
         printf("TLS Connected!\n");
         ctx->connected = true;
-        ctx->busy = false;
+        ctx->state = TLS_STATE_CONNECTED;
     } else {
         printf("TLS Connect failed: %d\n", err);
         ctx->connected = false;
+        ctx->state = TLS_STATE_FAILED;
     }
+    __sev();
     return ERR_OK;
 }
 
 // Intern funktion för att läsa (anropas av Paho)
-// Paho väntar på data här. Eftersom lwIP är callback-baserat måste vi fuska lite.
-// I denna förenklade version gör vi en "busy wait" på en buffer vi fyller i callbacken.
-// Notera: Detta kräver att vi modifierar tls_recv lite för att matcha Pahos buffer direkt
-// om vi kunde, men Paho ger buffern i stunden.
+// Paho vill ha exakt len bytes (t.ex. resten av ett paket) inom timeout_ms. Det som
+// redan ligger i ringen returneras direkt, annars sover vi i __wfe() tills tls_recv
+// har lagt dit mer eller tiden har gått ut.
 int paho_read(Network* n, unsigned char* buffer, int len, int timeout_ms) {
-    struct altcp_pcb *pcb = (struct altcp_pcb*)n->my_socket; // Vi sparade PCB-pekaren här
-    if (!pcb || !g_ctx.connected) return -1;
-
-    // Sätt upp den globala kontexten så recv-callbacken vet var den ska lägga data
-    g_ctx.buffer = buffer;
-    g_ctx.buffer_len = len;
-    g_ctx.buffer_pos = 0;
-
-    uint64_t end_time = time_us_64() + (timeout_ms * 1000);
-    
-    while (time_us_64() < end_time) {
-        // Låt lwIP jobba (viktigt för att callbacks ska köras!)
-        // Om du kör 'background'-läge sköter cyw43 detta, men en sleep hjälper
-        sleep_ms(1); 
-        
-        if (g_ctx.buffer_pos > 0) {
-            // Vi fick data i callbacken!
-            int read = g_ctx.buffer_pos;
-            g_ctx.buffer = NULL; // Nollställ
-            g_ctx.buffer_pos = 0;
-            return read;
-        }
-        if (!g_ctx.connected) return -1;
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+    int got = 0;
+
+    while (got < len) {
+        // tls_recv körs i lwIP:s bakgrundsavbrott, så ringen och kedjan läses under låset
+        cyw43_arch_lwip_begin();
+        int read = rx_take(&g_ctx, buffer + got, len - got);
+        bool connected = g_ctx.connected;
+        cyw43_arch_lwip_end();
+
+        got += read;
+        if (got == len) break;
+        if (!connected) return got > 0 ? got : -1; // Stängd och inget kvar att läsa
+        // Kommer tls_recv mellan kontrollen ovan och __wfe() har __sev() redan satt
+        // händelseflaggan, så vi somnar inte förbi datat
+        if (best_effort_wfe_or_timeout(deadline)) break;
     }
-    
-    g_ctx.buffer = NULL;
-    return 0; // Timeout
+    return got; // 0 = timeout
+}
+
+int TLSAvailable(Network* n) {
+    cyw43_arch_lwip_begin();
+    uint32_t avail = g_ctx.rx_head - g_ctx.rx_tail;
+    if (g_ctx.rx_chain) avail += g_ctx.rx_chain->tot_len;
+    cyw43_arch_lwip_end();
+    return (int)avail;
 }
 
 // Intern funktion för att skriva (anropas av Paho)
+// Skriver så mycket som får plats i sändbufferten. Är den full sover vi i __wfe()
+// tills tls_sent signalerar att servern har kvitterat något, högst timeout_ms.
+// Returnerar antal skrivna bytes; Paho anropar igen med resten.
 int paho_write(Network* n, unsigned char* buffer, int len, int timeout_ms) {
-    struct altcp_pcb *pcb = (struct altcp_pcb*)n->my_socket;
-    if (!pcb || !g_ctx.connected) return -1;
-
-    err_t err = altcp_write(pcb, buffer, len, TCP_WRITE_FLAG_COPY);
-    if (err != ERR_OK) {
-        printf("Writing data failed: %d\n", err);
-        return -1;
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+    int sent = 0;
+
+    while (sent < len) {
+        err_t err = ERR_CONN;
+        int chunk = 0;
+
+        cyw43_arch_lwip_begin();
+        if (g_ctx.pcb && g_ctx.connected) {
+            chunk = len - sent;
+            if (chunk > altcp_sndbuf(g_ctx.pcb)) chunk = altcp_sndbuf(g_ctx.pcb);
+            err = chunk > 0 ? altcp_write(g_ctx.pcb, buffer + sent, (u16_t)chunk, TCP_WRITE_FLAG_COPY) : ERR_MEM;
+            if (err == ERR_OK) altcp_output(g_ctx.pcb); // Tvinga sändning
+        }
+        cyw43_arch_lwip_end();
+
+        if (err == ERR_OK) {
+            sent += chunk;
+        } else if (err != ERR_MEM) {
+            printf("Writing data failed: %d\n", err);
+            return sent > 0 ? sent : -1;
+        } else if (best_effort_wfe_or_timeout(deadline)) {
+            break; // Fortfarande fullt, Paho avgör om det är ett fel
+        }
     }
-    
-    altcp_output(pcb); // Tvinga sändning
-    return len;
+    return sent;
 }
 
 void paho_disconnect(Network* n) {
-    struct altcp_pcb *pcb = (struct altcp_pcb*)n->my_socket;
-    if (pcb) {
-        altcp_close(pcb);
-        g_ctx.connected = false;
-        g_ctx.pcb = NULL;
-    }
+    TLSClose(n);
 }
 
-// DNS Callback
+// DNS Callback. Kan komma efter TLSClose() eller två gånger (cachad adress),
+// så den gör bara något medan kopplingen fortfarande väntar på adressen.
 static void dns_found(const char *name, const ip_addr_t *ipaddr, void *callback_arg) {
     TLSContext *ctx = (TLSContext*)callback_arg;
+    if (ctx->state != TLS_STATE_RESOLVING || !ctx->pcb) return;
+
     if (ipaddr) {
         printf("DNS Resolved: %s -> %s\n", name, ipaddr_ntoa(ipaddr));
-        altcp_connect(ctx->pcb, ipaddr, 8883, tls_connected);
+        ctx->state = TLS_STATE_CONNECTING;
+        err_t err = altcp_connect(ctx->pcb, ipaddr, ctx->port, tls_connected);
+        if (err != ERR_OK) {
+            printf("TCP connect failed: %d\n", err);
+            ctx->state = TLS_STATE_FAILED;
+        }
     } else {
         printf("DNS Resolution failed for %s\n", name);
-        ctx->busy = false; // Sluta vänta
+        ctx->state = TLS_STATE_FAILED;
     }
+    __sev();
 }
 
-// HUVUDFUNKTIONEN: Konfigurerar mTLS och kopplar upp
-void TLSConnect(Network* n, char* hostname, int port, const char* ca_cert, const char* client_cert, const char* client_key) {
+// Starta uppkopplingen: DNS, TCP och TLS-handskakning drivs sedan av lwIP-callbacks
+bool TLSConnectStart(Network* n, char* hostname, int port, const char* ca_cert, const char* client_cert, const char* client_key) {
+    // Konfigurationen (certifikaten) är densamma vid varje återanslutning, skapa den en gång
+    static struct altcp_tls_config *tls_config;
+
     // 1. Koppla Pahos funktionspekare
     n->mqttread = paho_read;
     n->mqttwrite = paho_write;
     n->disconnect = paho_disconnect;
 
+    TLSClose(n); // Eventuell gammal koppling
+
     printf("\n=== TLS SETUP (SNI ENABLED) ===\n");
     printf("Hostname for SNI: %s\n", hostname);
     
     // 2. Skapa TLS Konfiguration (mTLS)
     // OBS: Vi castar const char* till u8_t* och beräknar längd.
     // Detta antar att certifikaten är null-terminerade strängar.
-    struct altcp_tls_config *tls_config = altcp_tls_create_config_client_2wayauth(
-        (u8_t*)ca_cert, strlen(ca_cert) + 1,
-        (u8_t*)client_key, strlen(client_key) + 1,
-        NULL, 0, // Inget lösenord på nyckeln (vanligtvis)
-        (u8_t*)client_cert, strlen(client_cert) + 1
-    );
+    cyw43_arch_lwip_begin();
+    if (!tls_config) {
+        tls_config = altcp_tls_create_config_client_2wayauth(
+            (u8_t*)ca_cert, strlen(ca_cert) + 1,
+            (u8_t*)client_key, strlen(client_key) + 1,
+            NULL, 0, // Inget lösenord på nyckeln (vanligtvis)
+            (u8_t*)client_cert, strlen(client_cert) + 1
+        );
+    }
 
     if (!tls_config) {
+        cyw43_arch_lwip_end();
         printf("Failed to create TLS config! Check certs/keys/memory.\n");
-        return;
+        return false;
     }
 
    // mbedtls_ssl_conf_server_name((mbedtls_ssl_config*)tls_config, hostname);
@@ -208,18 +301,21 @@ void TLSConnect(Network* n, char* hostname, int port, const char* ca_cert, const
     // 3. Skapa TCP/TLS Control Block
     struct altcp_pcb *pcb = altcp_tls_new(tls_config, IPADDR_TYPE_ANY);
     if (!pcb) {
+        cyw43_arch_lwip_end();
         printf("Failed to create PCB!\n");
-        altcp_tls_free_config(tls_config);
-        return;
+        return false;
     }
 
     // 4. Sätt upp callbacks
+    rx_reset(&g_ctx);
     g_ctx.pcb = pcb;
     g_ctx.connected = false;
-    g_ctx.busy = true;
+    g_ctx.port = (u16_t)port;
+    g_ctx.state = TLS_STATE_RESOLVING;
     
     altcp_arg(pcb, &g_ctx);
     altcp_recv(pcb, tls_recv);
+    altcp_sent(pcb, tls_sent);
     altcp_err(pcb, tls_err);
 
     // 5. DNS Uppslagning och Anslutning
@@ -232,28 +328,51 @@ void TLSConnect(Network* n, char* hostname, int port, const char* ca_cert, const
         dns_found(hostname, &ip, &g_ctx);
     } else if (err != ERR_INPROGRESS) {
         printf("DNS setup failed: %d\n", err);
-        altcp_close(pcb);
-        return;
+        g_ctx.state = TLS_STATE_FAILED;
+    }
+    cyw43_arch_lwip_end();
+
+    // Spara PCB i nätverksstrukturen (read/write använder g_ctx)
+    n->my_socket = (int)pcb; // Fulhack att spara pekaren som int, men funkar i C
+    return g_ctx.state != TLS_STATE_FAILED;
+}
+
+TLSState TLSConnectState(Network* n) {
+    return g_ctx.state;
+}
+
+void TLSClose(Network* n) {
+    cyw43_arch_lwip_begin();
+    struct altcp_pcb *pcb = g_ctx.pcb;
+    if (pcb) {
+        // Inga fler callbacks till g_ctx från den här kopplingen
+        altcp_arg(pcb, NULL);
+        altcp_recv(pcb, NULL);
+        altcp_sent(pcb, NULL);
+        altcp_err(pcb, NULL);
+        if (altcp_close(pcb) != ERR_OK) altcp_abort(pcb);
     }
+    g_ctx.pcb = NULL;
+    g_ctx.connected = false;
+    g_ctx.state = TLS_STATE_IDLE;
+    rx_reset(&g_ctx);
+    cyw43_arch_lwip_end();
+    n->my_socket = 0;
+}
+
+// Blockerande variant: starta och vänta i __wfe() tills handskakningen är klar eller har misslyckats
+void TLSConnect(Network* n, char* hostname, int port, const char* ca_cert, const char* client_cert, const char* client_key) {
+    if (!TLSConnectStart(n, hostname, port, ca_cert, client_cert, client_key)) return;
 
-    // 6. Vänta på anslutning (Busy loop)
-    // Vi måste vänta här eftersom Paho förväntar sig att connect är synkront
     printf("Waiting for TLS handshake...\n");
-    int attempts = 0;
-    while (g_ctx.busy && attempts < 5000) { // 50 sekunders timeout
-        sleep_ms(10);
-        attempts++;
-        if (g_ctx.connected) {
-            g_ctx.busy = false; 
-            break;
-        }
+    absolute_time_t deadline = make_timeout_time_ms(50000); // 50 sekunders timeout
+    while (g_ctx.state == TLS_STATE_RESOLVING || g_ctx.state == TLS_STATE_CONNECTING) {
+        if (best_effort_wfe_or_timeout(deadline)) break;
     }
 
-    if (g_ctx.connected) {
-        // Spara PCB i nätverksstrukturen så read/write hittar den
-        n->my_socket = (int)pcb; // Fulhack att spara pekaren som int, men funkar i C
-    } else {
+    if (g_ctx.state != TLS_STATE_CONNECTED) {
         printf("TLS Connection Timed Out or Failed.\n");
+        TLSClose(n);
     }
 }
 
@@ -18,8 +18,25 @@ typedef struct Network
     void (*disconnect) (struct Network*);
 } Network;
 
+// Uppkopplingens fas. lwIP-callbacks flyttar den framåt, TLSConnectState() läser den.
+typedef enum {
+    TLS_STATE_IDLE,
+    TLS_STATE_RESOLVING,    // DNS-uppslagning
+    TLS_STATE_CONNECTING,   // TCP-anslutning och TLS-handskakning (altcp_tls rapporterar dem som en)
+    TLS_STATE_CONNECTED,
+    TLS_STATE_FAILED,       // Misslyckades, eller servern stängde / kopplingen dog
+} TLSState;
+
 // 3. Funktionsprototyper som Paho behöver
+// TLSConnect() väntar tills kopplingen är uppe eller har misslyckats. TLSConnectStart()
+// startar bara och returnerar direkt (false om det inte ens gick att starta).
 void TLSConnect(Network* n, char* hostname, int port, const char* ca_cert, const char* client_cert, const char* client_key);
+bool TLSConnectStart(Network* n, char* hostname, int port, const char* ca_cert, const char* client_cert, const char* client_key);
+TLSState TLSConnectState(Network* n);
+void TLSClose(Network* n);
+
+// Mottagna bytes som Paho inte har läst än (0 = inget att hämta)
+int TLSAvailable(Network* n);
 
 void TimerInit(Timer*);
 char TimerIsExpired(Timer*);
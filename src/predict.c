@@ -0,0 +1,81 @@
+#include "predict.h"
+#include <stdio.h>
+#include <string.h>
+
+void predict_init(predict_state_t *s, uint8_t count, uint32_t linear) {
+    memset(s, 0, sizeof(*s));
+    s->count = count > PREDICT_MAX_CHANNELS ? PREDICT_MAX_CHANNELS : count;
+    s->linear = linear;
+}
+
+int32_t predict_value(const predict_channel_t *c, uint32_t seq) {
+    if (!c->valid) return 0;
+
+    uint32_t dt = seq - c->seq;
+    if (dt > PREDICT_MAX_HORIZON) dt = PREDICT_MAX_HORIZON;
+
+    int64_t v = c->value + c->slope * (int64_t)dt / PREDICT_SLOPE_ONE;
+    return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+}
+
+uint32_t predict_check(const predict_state_t *s, uint32_t seq, const int32_t *values, const deadband_band_t *bands) {
+    uint32_t mask = 0;
+
+    for (uint8_t i = 0; i < s->count; i++) {
+        const predict_channel_t *c = &s->ch[i];
+        if (!c->valid) {
+            mask |= 1u << i;
+            continue;
+        }
+        int32_t pred = predict_value(c, seq);
+        int64_t err = (int64_t)values[i] - pred;
+        if ((err < 0 ? -err : err) > deadband_limit(&bands[i], pred)) mask |= 1u << i;
+    }
+    return mask;
+}
+
+bool predict_keyframe_due(const predict_state_t *s, uint32_t seq, uint32_t period) {
+    for (uint8_t i = 0; i < s->count; i++) {
+        if (!s->ch[i].valid) return true;
+    }
+    return seq - s->key_seq >= period;
+}
+
+void predict_apply(predict_state_t *s, uint32_t seq, const int32_t *values, uint32_t mask, bool keyframe) {
+    for (uint8_t i = 0; i < s->count; i++) {
+        predict_channel_t *c = &s->ch[i];
+
+        if (keyframe) {
+            c->slope = 0;
+        } else if (!(mask & (1u << i))) {
+            continue;
+        } else if (c->valid && seq != c->seq && (s->linear & (1u << i))) {
+            // Lutningen sedan förra skickade värdet. Vikten dt / (dt + TAU) gör att
+            // ett hopp strax efter förra värdet (brus, ett steg) inte ger en brant
+            // lutning, medan en lång jämn ramp nästan ersätter den gamla.
+            int64_t dt = (uint32_t)(seq - c->seq);
+            int64_t slope = ((int64_t)values[i] - c->value) * PREDICT_SLOPE_ONE / dt;
+            if (dt > PREDICT_MAX_HORIZON) dt = PREDICT_MAX_HORIZON;
+            c->slope += (slope - c->slope) * dt / (dt + PREDICT_SLOPE_TAU);
+        }
+        c->value = values[i];
+        c->seq = seq;
+        c->valid = true;
+    }
+    if (keyframe) s->key_seq = seq;
+    s->mseq++;
+}
+
+int predict_fmt_json(char *buf, size_t len, const char *id, const predict_state_t *s, uint32_t seq,
+                     const int32_t *values, uint32_t mask, bool keyframe, const char *const *names) {
+    int pos = snprintf(buf, len, "{\"id\": \"%s\", \"mseq\": %lu, \"seq\": %lu, \"key\": %d",
+                       id, (unsigned long)s->mseq, (unsigned long)seq, keyframe ? 1 : 0);
+
+    for (uint8_t i = 0; i < s->count && pos >= 0 && (size_t)pos < len; i++) {
+        if (keyframe || (mask & (1u << i))) {
+            pos += snprintf(buf + pos, len - pos, ", \"%s\": %ld", names[i], (long)values[i]);
+        }
+    }
+    if (pos >= 0 && (size_t)pos < len) pos += snprintf(buf + pos, len - pos, "}");
+    return pos;
+}
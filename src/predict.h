@@ -0,0 +1,63 @@
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "deadband.h"
+
+// Prediktiv kodning av mätvärden. Sändaren och mottagaren kör samma modell per
+// kanal: linjär extrapolation från senast skickade värdet, med en lutning som
+// glättas exponentiellt mellan skickade värden, eller för kanaler som ändras i
+// steg (gas) bara senast skickade värdet. Ett värde skickas bara när det
+// avviker mer än bandet från prediktionen, övriga räknar mottagaren fram själv.
+// Allt i heltal så att båda sidor får exakt samma prediktion.
+//
+// Meddelandena numreras (mseq) så att mottagaren märker tappade meddelanden,
+// och med jämna mellanrum skickas en keyframe med alla kanaler som startar om
+// modellen (lutning 0) på båda sidor. Mottagaren finns i tools/predict_decoder.
+
+#define PREDICT_MAX_CHANNELS DEADBAND_MAX_CHANNELS
+#define PREDICT_SLOPE_ONE 65536         // Lutningen i Q16, värdeenheter per mätning
+#define PREDICT_MAX_HORIZON 720         // Längre än så extrapoleras inte (1 h vid 5 s)
+#define PREDICT_SLOPE_TAU 120           // Mätningar, se predict_apply()
+
+typedef struct {
+    int32_t value;          // Senast skickade värde
+    uint32_t seq;           // Mätningen det gällde
+    int64_t slope;          // Q16 per mätning
+    bool valid;
+} predict_channel_t;
+
+typedef struct {
+    predict_channel_t ch[PREDICT_MAX_CHANNELS];
+    uint8_t count;
+    uint32_t linear;        // Kanaler (bitmask) med lutning
+    uint32_t mseq;          // Nästa meddelandes nummer
+    uint32_t key_seq;       // Mätningen för senaste keyframe
+} predict_state_t;
+
+// linear är en bitmask med de kanaler som extrapoleras, övriga hålls. Mottagaren
+// måste använda samma.
+void predict_init(predict_state_t *s, uint8_t count, uint32_t linear);
+
+// Modellens värde för kanalen vid mätning seq
+int32_t predict_value(const predict_channel_t *c, uint32_t seq);
+
+// Kanaler (bitmask) som avviker mer än sitt band från prediktionen.
+// Kanaler som aldrig skickats räknas alltid med.
+uint32_t predict_check(const predict_state_t *s, uint32_t seq, const int32_t *values, const deadband_band_t *bands);
+
+// true när det är dags för en keyframe: första gången eller var 'period' mätning
+bool predict_keyframe_due(const predict_state_t *s, uint32_t seq, uint32_t period);
+
+// Ett meddelande med kanalerna i mask har skickats (sändaren) eller tagits emot
+// (mottagaren). Uppdaterar modellen och räknar upp mseq.
+void predict_apply(predict_state_t *s, uint32_t seq, const int32_t *values, uint32_t mask, bool keyframe);
+
+// Meddelandet som JSON: {"id": "...", "mseq": n, "seq": n, "key": 0|1, "<kanal>": värde, ...}
+// med värdena i fixpunkt (heltal). Returnerar längden som snprintf.
+int predict_fmt_json(char *buf, size_t len, const char *id, const predict_state_t *s, uint32_t seq,
+                     const int32_t *values, uint32_t mask, bool keyframe, const char *const *names);
+
+#endif
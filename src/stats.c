@@ -0,0 +1,59 @@
+#include "stats.h"
+#include <string.h>
+
+void stats_reset(stats_t *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+void stats_add(stats_t *s, int32_t x) {
+    int64_t xs = (int64_t)x * (1 << STATS_FRAC_BITS);
+
+    if (s->n == 0) {
+        s->min = s->max = x;
+    } else {
+        if (x < s->min) s->min = x;
+        if (x > s->max) s->max = x;
+    }
+    s->last = x;
+    s->n++;
+
+    // Welford: avvikelsen mot gamla och nya medelvärdet
+    int64_t delta = xs - s->mean;
+    int64_t n = s->n;
+    s->mean += (delta + (delta < 0 ? -n : n) / 2) / n; // Avrundat, så att felet inte drar åt noll
+    int64_t prod = delta * (xs - s->mean);
+    if (prod > 0) s->m2 += (uint64_t)prod;
+}
+
+int32_t stats_mean(const stats_t *s) {
+    int64_t half = s->mean < 0 ? -(1 << (STATS_FRAC_BITS - 1)) : (1 << (STATS_FRAC_BITS - 1));
+    return (int32_t)((s->mean + half) / (1 << STATS_FRAC_BITS));
+}
+
+uint64_t stats_variance(const stats_t *s) {
+    if (s->n < 2) return 0;
+    return (s->m2 / (s->n - 1) + (1u << (2 * STATS_FRAC_BITS - 1))) >> (2 * STATS_FRAC_BITS);
+}
+
+uint32_t stats_stddev(const stats_t *s) {
+    if (s->n < 2) return 0;
+    // Roten före nedskalningen behåller bråkbitarna
+    return (stats_isqrt(s->m2 / (s->n - 1)) + (1u << (STATS_FRAC_BITS - 1))) >> STATS_FRAC_BITS;
+}
+
+uint32_t stats_isqrt(uint64_t x) {
+    uint64_t r = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) bit >>= 2;
+    while (bit) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
@@ -0,0 +1,34 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+// Strömmande statistik för en kanal: Welfords medelvärde och varians, min, max
+// och senaste värde. Fast minne och konstant tid per värde, bara heltal.
+// Medelvärdet hålls med STATS_FRAC_BITS bråkbitar; värdena måste ligga inom
+// ±2^27 (t.ex. ohm upp till 134 Mohm) för att kvadraterna ska rymmas i 64 bitar.
+#define STATS_FRAC_BITS 4
+
+typedef struct {
+    uint32_t n;
+    int32_t min;
+    int32_t max;
+    int32_t last;
+    int64_t mean;           // Medelvärde << STATS_FRAC_BITS
+    uint64_t m2;            // Summa av kvadrerade avvikelser << 2 * STATS_FRAC_BITS
+} stats_t;
+
+void stats_reset(stats_t *s);
+void stats_add(stats_t *s, int32_t x);
+
+// Medelvärdet avrundat till heltal, 0 om inga värden
+int32_t stats_mean(const stats_t *s);
+
+// Stickprovsvarians och standardavvikelse (n - 1), 0 med färre än två värden
+uint64_t stats_variance(const stats_t *s);
+uint32_t stats_stddev(const stats_t *s);
+
+// Heltalsroten
+uint32_t stats_isqrt(uint64_t x);
+
+#endif
@@ -0,0 +1,81 @@
+#include "warmup.h"
+#include "stats.h"
+#include <string.h>
+
+void warmup_init(warmup_t *w) {
+    memset(w, 0, sizeof(*w));
+}
+
+// Spridning och lutning över fönstret, i heltal så att inget flyttal behövs.
+// Tiden räknas i sekunder från äldsta mätningen, så produkterna ryms i int64
+// även med gasvärden på 100 Mohm.
+static bool window_stable(warmup_t *w) {
+    uint8_t first = (uint8_t)((w->head + WARMUP_WINDOW - w->count) % WARMUP_WINDOW);
+    uint32_t t0 = w->t_ms[first];
+    int64_t sum_t = 0, sum_g = 0;
+
+    for (uint8_t i = 0; i < w->count; i++) {
+        uint8_t k = (uint8_t)((first + i) % WARMUP_WINDOW);
+        sum_t += (w->t_ms[k] - t0) / 1000;
+        sum_g += w->gas[k];
+    }
+    int64_t mean_t = sum_t / w->count;
+    int64_t mean_g = sum_g / w->count;
+    if (mean_g <= 0) return false;
+
+    int64_t var = 0, num = 0, den = 0;
+    for (uint8_t i = 0; i < w->count; i++) {
+        uint8_t k = (uint8_t)((first + i) % WARMUP_WINDOW);
+        int64_t dt = (int64_t)((w->t_ms[k] - t0) / 1000) - mean_t;
+        int64_t dg = (int64_t)w->gas[k] - mean_g;
+        var += dg * dg;
+        num += dt * dg;
+        den += dt * dt;
+    }
+    var /= w->count;
+    if (den == 0) return false;
+
+    // Minsta kvadrat-lutning i ohm/s, uttryckt i promille av medelvärdet per minut
+    w->stddev_permille = (uint32_t)((uint64_t)stats_isqrt((uint64_t)var) * 1000 / (uint64_t)mean_g);
+    w->slope_permille = (uint32_t)((uint64_t)(num < 0 ? -num : num) * 60 * 1000 / ((uint64_t)den * (uint64_t)mean_g));
+
+    return w->t_ms[(w->head + WARMUP_WINDOW - 1) % WARMUP_WINDOW] - t0 >= WARMUP_MIN_SPAN_MS &&
+           w->stddev_permille <= WARMUP_MAX_STDDEV_PERMILLE &&
+           w->slope_permille <= WARMUP_MAX_SLOPE_PERMILLE;
+}
+
+void warmup_set_baseline(warmup_t *w, uint32_t gas) {
+    w->baseline = gas;
+}
+
+// De senaste WARMUP_BASELINE_SAMPLES mätningarna ligger nära den återställda baslinjen
+static bool near_baseline(const warmup_t *w) {
+    if (w->baseline == 0 || w->count < WARMUP_BASELINE_SAMPLES) return false;
+
+    uint32_t tol = (uint32_t)((uint64_t)w->baseline * WARMUP_BASELINE_PERMILLE / 1000);
+    for (uint8_t i = 1; i <= WARMUP_BASELINE_SAMPLES; i++) {
+        uint32_t gas = w->gas[(w->head + WARMUP_WINDOW - i) % WARMUP_WINDOW];
+        if ((gas > w->baseline ? gas - w->baseline : w->baseline - gas) > tol) return false;
+    }
+    return true;
+}
+
+bool warmup_add(warmup_t *w, uint32_t now_ms, uint32_t gas, bool heat_stab) {
+    if (w->stable) return true;
+    if (!heat_stab) {
+        w->count = 0;
+        return false;
+    }
+
+    w->t_ms[w->head] = now_ms;
+    w->gas[w->head] = gas;
+    w->head = (uint8_t)((w->head + 1) % WARMUP_WINDOW);
+    if (w->count < WARMUP_WINDOW) w->count++;
+
+    if (near_baseline(w)) {
+        w->stable = true;
+    } else if (w->count == WARMUP_WINDOW) {
+        w->stable = window_stable(w);
+    }
+    return w->stable;
+}
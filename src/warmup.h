@@ -0,0 +1,64 @@
+#ifndef WARMUP_H
+#define WARMUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Uppvärmningsdetektor för MOX-sensorn. Sensorn räknas som stabil när värmaren
+// har nått måltemperaturen (BME68X_HEAT_STAB_MSK) i alla mätningar i fönstret
+// och gasresistansen har planat ut: låg spridning och nästan ingen lutning.
+
+// Antal gasmätningar i fönstret
+#ifndef WARMUP_WINDOW
+#define WARMUP_WINDOW 12
+#endif
+
+// Fönstret måste täcka minst så här lång tid
+#ifndef WARMUP_MIN_SPAN_MS
+#define WARMUP_MIN_SPAN_MS 45000
+#endif
+
+// Största standardavvikelse i promille av medelvärdet
+#ifndef WARMUP_MAX_STDDEV_PERMILLE
+#define WARMUP_MAX_STDDEV_PERMILLE 15
+#endif
+
+// Största lutning i promille av medelvärdet per minut
+#ifndef WARMUP_MAX_SLOPE_PERMILLE
+#define WARMUP_MAX_SLOPE_PERMILLE 10
+#endif
+
+// Med en återställd baslinje (gas_baseline.h) räcker det att så här många
+// mätningar i rad ligger inom WARMUP_BASELINE_PERMILLE från den
+#ifndef WARMUP_BASELINE_SAMPLES
+#define WARMUP_BASELINE_SAMPLES 4
+#endif
+#ifndef WARMUP_BASELINE_PERMILLE
+#define WARMUP_BASELINE_PERMILLE 150
+#endif
+
+typedef struct {
+    uint32_t t_ms[WARMUP_WINDOW];   // Ringbuffert med tid och gasvärde
+    uint32_t gas[WARMUP_WINDOW];
+    uint8_t head;
+    uint8_t count;
+    uint32_t baseline;              // Återställd gasbaslinje (ohm), 0 = ingen
+    bool stable;                    // Låses när sensorn väl har blivit stabil
+    uint32_t stddev_permille;       // Senast beräknade värden, för utskrift
+    uint32_t slope_permille;        // Promille per minut, absolutbelopp
+} warmup_t;
+
+void warmup_init(warmup_t *w);
+
+// Lägg till en gasmätning. En mätning där värmaren inte nådde måltemperaturen
+// tömmer fönstret. Returnerar true när sensorn är stabil.
+bool warmup_add(warmup_t *w, uint32_t now_ms, uint32_t gas, bool heat_stab);
+
+// Sensorn hade en sparad baslinje som fortfarande gäller, se WARMUP_BASELINE_SAMPLES
+void warmup_set_baseline(warmup_t *w, uint32_t gas);
+
+static inline bool warmup_stable(const warmup_t *w) {
+    return w->stable;
+}
+
+#endif
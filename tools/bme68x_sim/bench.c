@@ -0,0 +1,316 @@
+// Värdbenchmark för BME680-drivrutinen (src/bme680.c + src/bme68x.c) mot
+// simulerade sensorer. Drivrutinen kompileras oförändrad; Pico SDK, i2c_dma och
+// flashen byts mot simulatorn i den här katalogen. För varje API-anrop skrivs
+// antal I2C-transaktioner, bytes på bussen, modellerad busstid, tid från anrop
+// till resultat och antal avbrott ut, så att en optimering kan mätas innan den
+// flashas ut.
+//
+// Bygg och kör från repo-roten (samma heltalsväg som firmwaren):
+//   gcc -O2 -Wall -DBME68X_DO_NOT_USE_FPU -Itools/bme68x_sim/shim -Itools/bme68x_sim -Isrc -o bme68x_sim
+//       tools/bme68x_sim/*.c src/bme680.c src/bme68x.c src/flash_store.c -lm
+//   ./bme68x_sim              (syntetiska mätvärden)
+//   ./bme68x_sim trace.txt    (spela upp inspelade rådata, se tools/compensation_bench)
+//
+// Lägg till -DBME680_I2C_BAUDRATE=1000000 för att räkna på Fast-mode Plus.
+//
+// Uppställning: i2c0 har BME680 på 0x76 och 0x77, i2c1 har BME688 på 0x76 och
+// 0x77. Med en trace får alla fyra tracens kalibrering och variant.
+#include "sim.h"
+#include "bme680.h"
+#include "bme68x.h"
+#include <string.h>
+
+#define READS 50
+
+// Samma typiska BME680-kalibrering som compensation_bench
+static const uint8_t default_calib[42] = {
+    0xfb, 0x66, 0x03, 0x00, 0x5e, 0x8e, 0x55, 0xd7, 0x58, 0x00, 0xda, 0x1a,
+    0x89, 0xff, 0x29, 0x1e, 0x00, 0x00, 0xfc, 0xfe, 0xd1, 0xf3, 0x1e, 0x3e,
+    0x8c, 0x30, 0x00, 0x2d, 0x14, 0x78, 0x9c, 0x1c, 0x66, 0x42, 0xd9, 0xe2,
+    0x12, 0x2c, 0x00, 0x10, 0x00, 0xf0,
+};
+
+static sim_bme68x_t devices[BME680_MAX_SENSORS];
+static bme680_t sensors[BME680_MAX_SENSORS];
+
+static sim_stats_t mark_stats;
+static uint64_t mark_us;
+
+static void mark(void) {
+    mark_stats = sim_stats;
+    mark_us = sim_now_us();
+}
+
+// Skriv ut skillnaden sedan mark(), per anrop
+static void report(const char *name, unsigned calls) {
+    double n = calls ? calls : 1;
+
+    printf("%-44s %6.1f %6.1f %7.1f %9.1f %10.1f %6.1f\n", name,
+           (sim_stats.reads - mark_stats.reads) / n,
+           (sim_stats.writes - mark_stats.writes) / n,
+           (sim_stats.bytes - mark_stats.bytes) / n,
+           (sim_stats.bus_ns - mark_stats.bus_ns) / 1000.0 / n,
+           (sim_now_us() - mark_us) / n,
+           (sim_stats.irqs - mark_stats.irqs) / n);
+    if (sim_stats.nacks != mark_stats.nacks) printf("  (%u NACK)\n", (unsigned)(sim_stats.nacks - mark_stats.nacks));
+    if (sim_stats.flash_erases != mark_stats.flash_erases) {
+        printf("  (flash: %u raderade sektorer, %u sidor)\n", (unsigned)(sim_stats.flash_erases - mark_stats.flash_erases),
+               (unsigned)(sim_stats.flash_pages - mark_stats.flash_pages));
+    }
+}
+
+static const char *variant_name(const bme680_t *sensor) {
+    return sensor->dev.variant_id == BME68X_VARIANT_GAS_HIGH ? "BME688" : "BME680";
+}
+
+// Som huvudloopen: driv mätningen och sov (hoppa i tiden) mellan avbrotten
+static void run_idle(bme680_t *sensor) {
+    while (bme680_async_busy(sensor)) {
+        bme680_async_task(sensor);
+        if (!bme680_async_busy(sensor)) break;
+        if (!sim_run_next(UINT64_MAX)) break;
+    }
+}
+
+static unsigned read_fails;
+static bme680_reading_t last_reading;
+
+static void read_cb(bme680_t *sensor, bool ok, const bme680_reading_t *reading, void *user_data) {
+    if (ok) {
+        last_reading = *reading;
+    } else {
+        read_fails++;
+    }
+}
+
+static bme680_scan_t last_scan;
+static bool scan_ok;
+
+static void scan_cb(bme680_t *sensor, bool ok, const bme680_scan_t *scan, void *user_data) {
+    scan_ok = ok;
+    if (ok) last_scan = *scan;
+}
+
+// Originalflödet före drivrutinens optimeringar: forced mode, sov värsta
+// fallet och läs med Bosch bme68x_get_data()
+static void bench_bosch_polled(bme680_t *sensor) {
+    const bme680_session_t *s = bme680_get_session(sensor);
+    struct bme68x_conf conf = s->conf;
+    struct bme68x_data data;
+    uint8_t n_fields;
+
+    mark();
+    for (int i = 0; i < READS; i++) {
+        bme68x_set_op_mode(BME68X_FORCED_MODE, &sensor->dev);
+        sleep_us(bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &sensor->dev) + s->heat_dur_us);
+        if (bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &sensor->dev) != BME68X_OK) read_fails++;
+    }
+    report("bme68x_get_data, forced + sleep (Bosch)", READS);
+}
+
+static void bench_single(bme680_t *sensor) {
+    float t, h, p, g;
+
+    // Första läsningen väntar värsta fallet, sedan lär sig drivrutinen mättiden
+    mark();
+    if (!bme680_read(sensor, &t, &h, &p, &g)) read_fails++;
+    report("bme680_read, första", 1);
+    printf("  %.2f °C, %.2f %%RH, %.2f hPa, %.0f ohm\n", t, h, p, g);
+
+    mark();
+    for (int i = 0; i < READS; i++) {
+        if (!bme680_read(sensor, NULL, NULL, NULL, NULL)) read_fails++;
+    }
+    report("bme680_read, blockerande", READS);
+
+    mark();
+    for (int i = 0; i < READS; i++) {
+        if (!bme680_read_async(sensor, read_cb, NULL)) read_fails++;
+        run_idle(sensor);
+    }
+    report("bme680_read_async + async_task", READS);
+
+    mark();
+    for (int i = 0; i < READS; i++) {
+        if (!bme680_read_tph_async(sensor, read_cb, NULL)) read_fails++;
+        run_idle(sensor);
+    }
+    report("bme680_read_tph_async, utan värmare", READS);
+
+    // Multi-rate som i main.c: gas var sjätte mätning, T/H/P däremellan
+    mark();
+    for (int i = 0; i < READS; i++) {
+        bool ok = (i % 6 == 0) ? bme680_read_async(sensor, read_cb, NULL) : bme680_read_tph_async(sensor, read_cb, NULL);
+        if (!ok) read_fails++;
+        run_idle(sensor);
+    }
+    report("multi-rate, gas var 6:e mätning", READS);
+}
+
+static void bench_configure(bme680_t *sensor) {
+    const bme680_session_t *s = bme680_get_session(sensor);
+    struct bme68x_conf conf = s->conf;
+    struct bme68x_heatr_conf heatr = s->heatr_conf;
+
+    mark();
+    bme680_configure(sensor, &conf, &heatr);
+    report("bme680_configure, oförändrad", 1);
+
+    heatr.heatr_temp = 300;
+    mark();
+    bme680_configure(sensor, &conf, &heatr);
+    report("bme680_configure, ny värmartemperatur", 1);
+
+    heatr.heatr_temp = s->heatr_conf.heatr_temp == 300 ? 320 : heatr.heatr_temp;
+    bme680_configure(sensor, &conf, &heatr);
+}
+
+static void bench_group(size_t count) {
+    bme680_group_t group;
+    char name[64];
+
+    bme680_group_init(&group);
+    for (size_t i = 0; i < count; i++) bme680_group_add(&group, &sensors[i]);
+
+    mark();
+    for (int i = 0; i < READS; i++) {
+        bme680_group_read_async(&group, read_cb, NULL);
+        while (bme680_group_busy(&group)) {
+            bme680_group_task(&group);
+            if (bme680_group_busy(&group) && !sim_run_next(UINT64_MAX)) break;
+        }
+    }
+    snprintf(name, sizeof(name), "bme680_group_read_async, %zu sensorer", count);
+    report(name, READS);
+}
+
+static void bench_continuous(bme680_t *sensor) {
+    char name[64];
+
+    if (!bme680_continuous_start(sensor, BME68X_FILTER_SIZE_3, BME68X_ODR_1000_MS)) {
+        printf("%s: inget kontinuerligt läge (bara filter)\n", variant_name(sensor));
+        return;
+    }
+
+    // En läsning per sekund, sensorn mäter själv däremellan
+    mark();
+    for (int i = 0; i < READS; i++) {
+        sim_run_until(sim_now_us() + 1000000);
+        mark_us += 1000000; // Räkna bara läsningens tid, inte väntan
+        if (!bme680_read_async(sensor, read_cb, NULL)) read_fails++;
+        run_idle(sensor);
+    }
+    snprintf(name, sizeof(name), "bme680_read_async, kontinuerligt (%s)", variant_name(sensor));
+    report(name, READS);
+    bme680_continuous_stop(sensor);
+}
+
+static void bench_scan(bme680_t *sensor) {
+    bme680_profile_t profile = { .len = BME680_PROFILE_MAX_STEPS };
+    bool parallel = sensor->dev.variant_id == BME68X_VARIANT_GAS_HIGH;
+    char name[64];
+
+    for (uint8_t i = 0; i < profile.len; i++) {
+        profile.temp[i] = (uint16_t)(100 + 25 * i);
+        // Samma värmartid per steg: en cykel på BME680_SCAN_HEAT_MS på BME688
+        profile.dur[i] = parallel ? 1 : BME680_SCAN_HEAT_MS;
+    }
+
+    mark();
+    if (!bme680_scan_async(sensor, &profile, scan_cb, NULL)) {
+        printf("%s: profilskanningen startade inte\n", variant_name(sensor));
+        return;
+    }
+    run_idle(sensor);
+    snprintf(name, sizeof(name), "bme680_scan_async, %u steg (%s)", (unsigned)profile.len, variant_name(sensor));
+    report(name, 1);
+    if (scan_ok) {
+        printf("  giltiga steg 0x%03x, gas:", last_scan.valid);
+        for (uint8_t i = 0; i < last_scan.len; i++) printf(" %lu", (unsigned long)last_scan.gas[i]);
+        printf(" ohm\n");
+    } else {
+        printf("  skanningen misslyckades\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    static sim_trace_t trace;
+    static const uint8_t addrs[BME680_MAX_SENSORS] = {
+        BME68X_I2C_ADDR_LOW, BME68X_I2C_ADDR_HIGH, BME68X_I2C_ADDR_LOW, BME68X_I2C_ADDR_HIGH,
+    };
+    bool use_trace = argc > 1;
+
+    memcpy(trace.calib, default_calib, sizeof(trace.calib));
+    if (use_trace && sim_trace_load(&trace, argv[1]) != 0) return 1;
+
+    sim_flash_reset();
+    for (int i = 0; i < BME680_MAX_SENSORS; i++) {
+        uint8_t variant = use_trace ? trace.variant : (i < 2 ? BME68X_VARIANT_GAS_LOW : BME68X_VARIANT_GAS_HIGH);
+        sim_bme68x_init(&devices[i], variant, trace.calib);
+        if (use_trace) sim_bme68x_set_trace(&devices[i], &trace);
+        sim_bus_attach(i / 2, addrs[i], &devices[i]);
+    }
+
+    bme680_bus_init(i2c0, 4, 5);
+    bme680_bus_init(i2c1, 6, 7);
+
+    printf("I2C %u Hz, %s\n\n", (unsigned)BME680_I2C_BAUDRATE, use_trace ? argv[1] : "syntetiska mätvärden");
+    printf("%-44s %6s %6s %7s %9s %10s %6s\n", "Per anrop", "läs", "skriv", "bytes", "buss us", "tid us", "avbr");
+
+    mark();
+    if (!bme680_init(&sensors[0], i2c0, addrs[0])) {
+        printf("bme680_init misslyckades\n");
+        return 1;
+    }
+    report("bme680_init, kalibrering över I2C", 1);
+
+    mark();
+    bme680_init(&sensors[0], i2c0, addrs[0]);
+    report("bme680_init, kalibrering från flash", 1);
+
+    // Utbytt sensor på samma adress: posten i flash får inte användas
+    uint8_t variant0 = use_trace ? trace.variant : BME68X_VARIANT_GAS_LOW;
+    uint8_t replaced[sizeof(trace.calib)];
+    memcpy(replaced, trace.calib, sizeof(replaced));
+    replaced[BME68X_IDX_T1_LSB] ^= 0x10;
+    sim_bme68x_init(&devices[0], variant0, replaced);
+    mark();
+    bme680_init(&sensors[0], i2c0, addrs[0]);
+    report("bme680_init, utbytt sensor", 1);
+    if (sensors[0].dev.calib.par_t1 == (uint16_t)((replaced[BME68X_IDX_T1_MSB] << 8) | replaced[BME68X_IDX_T1_LSB])) {
+        printf("  ny kalibrering lästes från sensorn\n");
+    } else {
+        printf("  gammal kalibrering från flash användes\n");
+    }
+    sim_bme68x_init(&devices[0], variant0, trace.calib);
+    if (use_trace) sim_bme68x_set_trace(&devices[0], &trace);
+    bme680_init(&sensors[0], i2c0, addrs[0]);
+
+    mark();
+    bme680_t missing;
+    bme680_init(&missing, i2c1, 0x40);
+    report("bme680_init, ingen sensor", 1);
+
+    bench_configure(&sensors[0]);
+    bench_bosch_polled(&sensors[0]);
+    bench_single(&sensors[0]);
+
+    for (int i = 1; i < BME680_MAX_SENSORS; i++) {
+        if (!bme680_init(&sensors[i], i < 2 ? i2c0 : i2c1, addrs[i])) {
+            printf("bme680_init %d misslyckades\n", i);
+            return 1;
+        }
+    }
+    bench_group(2);
+    bench_group(BME680_MAX_SENSORS);
+
+    bench_continuous(&sensors[2]);
+    bench_scan(&sensors[0]);
+    bench_scan(&sensors[2]);
+
+    printf("\nbme680_print_timing efter %lu mätningar:\n", (unsigned long)devices[0].measurements);
+    bme680_print_timing(&sensors[0]);
+    printf("Registerskuggan har sparat %lu transaktioner, %u misslyckade läsningar\n",
+           (unsigned long)bme680_saved_transfers(&sensors[0]), read_fails);
+    return read_fails ? 1 : 0;
+}
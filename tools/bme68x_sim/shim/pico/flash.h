@@ -0,0 +1,9 @@
+#ifndef SIM_PICO_FLASH_H
+#define SIM_PICO_FLASH_H
+
+#include "pico/stdlib.h"
+
+// Inga avbrott eller andra kärnor att stoppa på värddatorn, func körs direkt
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+
+#endif
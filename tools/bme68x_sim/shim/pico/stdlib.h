@@ -0,0 +1,40 @@
+// Värdversion av den del av Pico SDK som bme680.c och flash_store.c använder.
+// Tiden är simulatorns virtuella klocka (sim_clock.c), inte värddatorns, och
+// alarm/DMA-avbrott körs som händelser på den klockan.
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define PICO_OK 0
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_us(uint64_t us);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+
+// Kör nästa händelse före timeout_timestamp (motsvarar att __wfe() väcks av ett
+// avbrott) och returnerar false, eller flyttar klockan till timeout och returnerar true
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+static inline void __wfe(void) {}
+static inline void __sev(void) {}
+static inline void tight_loop_contents(void) {}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "pico/stdlib.h"
+#include "sim_bme68x.h"
+
+// Räknare för allt som händer i simuleringen. Benchen tar en kopia före och
+// efter varje API-anrop och skriver ut skillnaden.
+typedef struct {
+    uint32_t reads;         // I2C-läsningar (registeradress + repeated start + data)
+    uint32_t writes;        // I2C-skrivningar
+    uint32_t nacks;         // Transaktioner som ingen enhet svarade på
+    uint64_t bytes;         // Bytes på bussen inklusive adress- och registerbytes
+    uint64_t bus_ns;        // Modellerad busstid vid bussens baudrate
+    uint32_t irqs;          // Avbrott: timeralarm och klara DMA-överföringar
+    uint32_t flash_erases;  // Raderade sektorer
+    uint32_t flash_pages;   // Programmerade sidor
+} sim_stats_t;
+
+extern sim_stats_t sim_stats;
+
+// Virtuell klocka (sim_clock.c)
+uint64_t sim_now_us(void);
+
+// Kör alla händelser fram till t_us och ställ klockan där
+void sim_run_until(uint64_t t_us);
+
+// Kör nästa händelse om den ligger senast limit_us. Returnerar false om ingen fanns.
+bool sim_run_next(uint64_t limit_us);
+
+// Intern händelse (t.ex. en klar DMA-överföring) som körs som ett avbrott vid due_us
+bool sim_schedule(uint64_t due_us, void (*fn)(void *arg), void *arg);
+
+// Koppla en simulerad sensor till adress addr på buss 0 (i2c0) eller 1 (i2c1)
+void sim_bus_attach(uint bus, uint8_t addr, sim_bme68x_t *dev);
+
+// Radera hela den simulerade flashen (som en nyprogrammerad nod)
+void sim_flash_reset(void);
+
+#endif
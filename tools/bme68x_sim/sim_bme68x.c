@@ -0,0 +1,331 @@
+// Registermodell av BME680/BME688 enligt databladet: chip-id, variant,
+// kalibreringsbankerna, tre fältregister à 17 bytes, värmarregistren och
+// forced/sekventiellt/parallellt läge med mättider från ctrl_hum/ctrl_meas,
+// gas_wait och shd_heatr_dur.
+//
+// Sensorn uppdateras lat: varje registeråtkomst kör först alla mätningar som
+// hunnit bli klara fram till åtkomstens tidpunkt. new_data sätts när ett fält
+// skrivs och nollas i forced mode när nästa mätning triggas; i sekventiellt och
+// parallellt läge ligger flaggan kvar tills fältet skrivs över, så samma fält
+// kan läsas flera gånger (drivrutinen sorterar på meas_index).
+//
+// Mätvärdena kommer från en trace (compensation_bench-formatet) eller från en
+// syntetisk inomhusmiljö där gasresistansen sjunker med värmartemperaturen.
+#include "sim_bme68x.h"
+#include "bme68x_defs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Riktiga sensorer blir klara något före databladets värsta fall, vilket
+// drivrutinens inlärda väntetid ska kunna utnyttja
+#define SIM_TIMING_SCALE 0.93
+
+// Värmaren räknas som stabil efter så här lång hålltid (forced och sekventiellt)
+#define SIM_HEAT_STAB_MS 20
+
+#define FIELD_STATUS_MEASURING 0x20
+#define FIELD_STATUS_GAS_MEASURING 0x40
+
+static const uint8_t os_cycles[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+
+// Standby mellan cykler i sekventiellt läge, index odr[2:0] (us)
+static const uint32_t odr_standby_us[8] = { 590, 62500, 125000, 250000, 500000, 1000000, 10000, 20000 };
+
+static uint8_t *field_regs(sim_bme68x_t *dev, uint8_t slot) {
+    return &dev->regs[BME68X_REG_FIELD0 + slot * BME68X_LEN_FIELD_OFFSET];
+}
+
+static bool gas_enabled(const sim_bme68x_t *dev) {
+    return (dev->regs[BME68X_REG_CTRL_GAS_1] & BME68X_RUN_GAS_MSK) &&
+           !(dev->regs[BME68X_REG_CTRL_GAS_0] & BME68X_HCTRL_MSK);
+}
+
+static uint8_t nb_conv(const sim_bme68x_t *dev) {
+    return dev->regs[BME68X_REG_CTRL_GAS_1] & BME68X_NBCONV_MSK;
+}
+
+// TPH-mätningen, samma formel som bme68x_get_meas_dur() skalad till "verklig" tid
+static uint32_t tph_us(const sim_bme68x_t *dev, bool parallel) {
+    uint8_t ctrl_meas = dev->regs[BME68X_REG_CTRL_MEAS];
+    uint32_t cycles = os_cycles[ctrl_meas >> 5] + os_cycles[(ctrl_meas >> 2) & 0x07] +
+                      os_cycles[dev->regs[BME68X_REG_CTRL_HUM] & BME68X_OSH_MSK];
+    uint32_t us = cycles * 1963 + 477 * 4 + 477 * 5;
+
+    if (!parallel) us += 1000;
+    return (uint32_t)(us * dev->timing_scale);
+}
+
+// gas_wait: bit 0-5 tid i ms, bit 6-7 multiplikator 1, 4, 16, 64
+static uint32_t gas_wait_ms(uint8_t v) {
+    return (uint32_t)(v & 0x3f) << (2 * (v >> 6));
+}
+
+// shd_heatr_dur: samma kodning i steg om 0.477 ms
+static uint32_t shared_heatr_us(uint8_t v) {
+    return ((uint32_t)(v & 0x3f) << (2 * (v >> 6))) * 477;
+}
+
+// Kod för gasresistansen: minsta område där ADC-värdet ryms (formlerna i calc_gas_resistance_*)
+static void gas_encode(const sim_bme68x_t *dev, double ohm, uint8_t flags, uint8_t *f) {
+    uint8_t range = 0;
+    int adc = 512;
+
+    for (uint8_t r = 0; r < 16; r++) {
+        double a;
+        if (dev->variant == BME68X_VARIANT_GAS_HIGH) {
+            a = 512.0 + (1e6 * (double)(262144u >> r) / ohm - 4096.0) / 3.0;
+        } else {
+            a = 512.0 + 1340.0 * (1.0 / (0.000000125 * (double)(1u << r) * ohm) - 1.0);
+        }
+        if (a >= 0.0 && a <= 1023.0) {
+            range = r;
+            adc = (int)(a + 0.5);
+            break;
+        }
+    }
+
+    uint8_t *g = (dev->variant == BME68X_VARIANT_GAS_HIGH) ? &f[15] : &f[13];
+    g[0] = (uint8_t)(adc >> 2);
+    g[1] = (uint8_t)((adc << 6) | flags | range);
+}
+
+// Fyll ett fälts rådata (byte 2..16) för mätning nummer dev->measurements
+static void fill_adc(sim_bme68x_t *dev, uint8_t *f, bool heat_stab) {
+    uint8_t flags = 0;
+
+    if (gas_enabled(dev)) flags = BME68X_GASM_VALID_MSK | (heat_stab ? BME68X_HEAT_STAB_MSK : 0);
+
+    if (dev->trace && dev->trace->n_fields) {
+        memcpy(&f[2], &dev->trace->fields[dev->measurements % dev->trace->n_fields][2], BME68X_LEN_FIELD - 2);
+        f[14] &= (uint8_t)~(BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK);
+        f[16] &= (uint8_t)~(BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK);
+        f[dev->variant == BME68X_VARIANT_GAS_HIGH ? 16 : 14] |= flags;
+        return;
+    }
+
+    // Ca 22 °C, 990 hPa och 49 %RH med standardkalibreringen, med lite brus
+    int wobble = (int)((dev->measurements * 7u) % 21u) - 10;
+    uint32_t temp_adc = (uint32_t)(488000 + wobble * 60);
+    uint32_t pres_adc = (uint32_t)(360000 - wobble * 30);
+    uint16_t hum_adc = (uint16_t)(22000 + wobble * 20);
+
+    memset(&f[2], 0, BME68X_LEN_FIELD - 2);
+    f[2] = (uint8_t)(pres_adc >> 12); f[3] = (uint8_t)(pres_adc >> 4); f[4] = (uint8_t)(pres_adc << 4);
+    f[5] = (uint8_t)(temp_adc >> 12); f[6] = (uint8_t)(temp_adc >> 4); f[7] = (uint8_t)(temp_adc << 4);
+    f[8] = (uint8_t)(hum_adc >> 8); f[9] = (uint8_t)hum_adc;
+
+    // Metalloxiden leder bättre ju varmare den är: res_heat-koden styr resistansen
+    double code = dev->regs[BME68X_REG_RES_HEAT0 + dev->step];
+    double ohm = 250000.0 * exp(-code / 90.0) * (1.0 + wobble * 0.002);
+    gas_encode(dev, ohm, flags, f);
+}
+
+// En mätning klar: skriv fältet och sätt new_data
+static void field_done(sim_bme68x_t *dev, uint8_t slot, bool heat_stab) {
+    uint8_t *f = field_regs(dev, slot);
+
+    fill_adc(dev, f, heat_stab);
+    f[0] = BME68X_NEW_DATA_MSK | (dev->step & BME68X_GAS_INDEX_MSK);
+    f[1] = dev->meas_index++;
+    dev->measurements++;
+}
+
+static uint32_t forced_us(const sim_bme68x_t *dev) {
+    uint32_t us = tph_us(dev, false);
+
+    if (gas_enabled(dev)) us += gas_wait_ms(dev->regs[BME68X_REG_GAS_WAIT0 + dev->step]) * 1000;
+    return us;
+}
+
+static uint32_t parallel_cycle_us(const sim_bme68x_t *dev) {
+    return tph_us(dev, true) + shared_heatr_us(dev->regs[BME68X_REG_SHD_HEATR_DUR]);
+}
+
+static uint32_t sequential_standby_us(const sim_bme68x_t *dev) {
+    if (dev->regs[BME68X_REG_CTRL_GAS_1] & BME68X_ODR3_MSK) return 0;
+    return odr_standby_us[dev->regs[BME68X_REG_CONFIG] >> BME68X_ODR20_POS];
+}
+
+static uint8_t profile_steps(const sim_bme68x_t *dev) {
+    uint8_t n = nb_conv(dev);
+    return (n == 0 || n > BME68X_MAX_PROFILE_LEN) ? 1 : n;
+}
+
+// Kör de mätningar som hunnit bli klara fram till now_us
+static void advance(sim_bme68x_t *dev, uint64_t now_us) {
+    switch (dev->mode) {
+    case BME68X_FORCED_MODE:
+        if (now_us >= dev->done_us) {
+            field_done(dev, 0, gas_wait_ms(dev->regs[BME68X_REG_GAS_WAIT0 + dev->step]) >= SIM_HEAT_STAB_MS);
+            dev->mode = BME68X_SLEEP_MODE;
+            dev->regs[BME68X_REG_CTRL_MEAS] &= (uint8_t)~BME68X_MODE_MSK;
+        }
+        break;
+    case BME68X_SEQUENTIAL_MODE:
+        while (now_us >= dev->done_us) {
+            field_done(dev, dev->slot, gas_wait_ms(dev->regs[BME68X_REG_GAS_WAIT0 + dev->step]) >= SIM_HEAT_STAB_MS);
+            dev->slot = (uint8_t)((dev->slot + 1) % 3);
+            dev->step = (uint8_t)((dev->step + 1) % profile_steps(dev));
+            dev->done_us += sequential_standby_us(dev) + forced_us(dev);
+        }
+        break;
+    case BME68X_PARALLEL_MODE:
+        // gas_wait är här antal cykler per steg; värmaren är stabil i stegets sista
+        // cykel om steget sammanlagt värmt minst SIM_HEAT_STAB_MS
+        while (now_us >= dev->done_us) {
+            uint8_t cycles = dev->regs[BME68X_REG_GAS_WAIT0 + dev->step];
+            bool last = dev->step_cycle + 1 >= (cycles ? cycles : 1);
+            uint32_t heat_us = (uint32_t)(dev->step_cycle + 1) * parallel_cycle_us(dev);
+
+            field_done(dev, dev->slot, last && heat_us >= SIM_HEAT_STAB_MS * 1000);
+            dev->slot = (uint8_t)((dev->slot + 1) % 3);
+            if (last) {
+                dev->step = (uint8_t)((dev->step + 1) % profile_steps(dev));
+                dev->step_cycle = 0;
+            } else {
+                dev->step_cycle++;
+            }
+            dev->done_us += parallel_cycle_us(dev);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void mode_start(sim_bme68x_t *dev, uint8_t mode, uint64_t now_us) {
+    uint8_t *f0 = field_regs(dev, 0);
+
+    dev->mode = mode;
+    dev->step_cycle = 0;
+    switch (mode) {
+    case BME68X_FORCED_MODE:
+        // Forced använder värmarsteget som nb_conv pekar ut
+        dev->step = nb_conv(dev) % BME68X_MAX_PROFILE_LEN;
+        dev->done_us = now_us + forced_us(dev);
+        f0[0] = FIELD_STATUS_MEASURING | (gas_enabled(dev) ? FIELD_STATUS_GAS_MEASURING : 0);
+        break;
+    case BME68X_SEQUENTIAL_MODE:
+        dev->step = 0;
+        dev->slot = 0;
+        dev->done_us = now_us + forced_us(dev);
+        break;
+    case BME68X_PARALLEL_MODE:
+        dev->step = 0;
+        dev->slot = 0;
+        dev->done_us = now_us + parallel_cycle_us(dev);
+        break;
+    default:
+        break;
+    }
+}
+
+static void soft_reset(sim_bme68x_t *dev) {
+    memset(&dev->regs[BME68X_REG_FIELD0], 0, BME68X_LEN_FIELD * 3);
+    memset(&dev->regs[BME68X_REG_IDAC_HEAT0], 0, BME68X_REG_CONFIG - BME68X_REG_IDAC_HEAT0 + 1);
+    dev->mode = BME68X_SLEEP_MODE;
+    dev->meas_index = 0;
+    dev->slot = 0;
+    dev->step = 0;
+}
+
+static void write_one(sim_bme68x_t *dev, uint64_t now_us, uint8_t reg, uint8_t val) {
+    if (reg == BME68X_REG_SOFT_RESET) {
+        if (val == BME68X_SOFT_RESET_CMD) soft_reset(dev);
+        return;
+    }
+    // Bara värmar- och kontrollregistren går att skriva, resten är data och NVM
+    if (reg < BME68X_REG_IDAC_HEAT0 || reg > BME68X_REG_CONFIG) return;
+
+    dev->regs[reg] = val;
+    if (reg == BME68X_REG_CTRL_MEAS) {
+        uint8_t mode = val & BME68X_MODE_MSK;
+        if (mode == BME68X_SLEEP_MODE) {
+            dev->mode = BME68X_SLEEP_MODE;
+        } else if (mode != dev->mode) {
+            mode_start(dev, mode, now_us);
+        }
+    }
+}
+
+void sim_bme68x_init(sim_bme68x_t *dev, uint8_t variant, const uint8_t *calib) {
+    memset(dev, 0, sizeof(*dev));
+    dev->variant = variant;
+    dev->timing_scale = SIM_TIMING_SCALE;
+
+    memcpy(&dev->regs[BME68X_REG_COEFF1], calib, BME68X_LEN_COEFF1);
+    memcpy(&dev->regs[BME68X_REG_COEFF2], &calib[BME68X_LEN_COEFF1], BME68X_LEN_COEFF2);
+    memcpy(&dev->regs[BME68X_REG_COEFF3], &calib[BME68X_LEN_COEFF1 + BME68X_LEN_COEFF2], BME68X_LEN_COEFF3);
+    dev->regs[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+    dev->regs[BME68X_REG_VARIANT_ID] = variant;
+    dev->regs[BME68X_REG_UNIQUE_ID] = 0x42;
+    soft_reset(dev);
+}
+
+void sim_bme68x_set_trace(sim_bme68x_t *dev, const sim_trace_t *trace) {
+    dev->trace = trace;
+}
+
+void sim_bme68x_read(sim_bme68x_t *dev, uint64_t now_us, uint8_t reg, uint8_t *dst, size_t len) {
+    advance(dev, now_us);
+    for (size_t i = 0; i < len; i++) dst[i] = dev->regs[(uint8_t)(reg + i)];
+}
+
+void sim_bme68x_write(sim_bme68x_t *dev, uint64_t now_us, uint8_t reg, const uint8_t *src, size_t len) {
+    advance(dev, now_us);
+    if (len == 0) return;
+    write_one(dev, now_us, reg, src[0]);
+    for (size_t i = 1; i + 1 < len; i += 2) write_one(dev, now_us, src[i], src[i + 1]);
+}
+
+static int parse_hex(const char *s, uint8_t *out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned int v;
+        while (*s == ' ') s++;
+        if (sscanf(s, "%2x", &v) != 1) return -1;
+        out[i] = (uint8_t)v;
+        s += 2;
+    }
+    return 0;
+}
+
+int sim_trace_load(sim_trace_t *trace, const char *path) {
+    char line[256];
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    trace->fields = calloc(SIM_TRACE_MAX_FIELDS, sizeof(*trace->fields));
+    trace->n_fields = 0;
+    if (!trace->fields) {
+        fclose(f);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (strncmp(line, "calib ", 6) == 0) {
+            if (parse_hex(line + 6, trace->calib, sizeof(trace->calib)) != 0) goto bad;
+        } else if (strncmp(line, "variant ", 8) == 0) {
+            trace->variant = (uint8_t)atoi(line + 8);
+        } else if (strncmp(line, "field ", 6) == 0) {
+            if (trace->n_fields < SIM_TRACE_MAX_FIELDS &&
+                parse_hex(line + 6, trace->fields[trace->n_fields++], BME68X_LEN_FIELD) != 0) {
+                goto bad;
+            }
+        } else {
+            goto bad;
+        }
+    }
+    fclose(f);
+    return 0;
+
+bad:
+    fprintf(stderr, "%s: ogiltig rad: %s", path, line);
+    fclose(f);
+    return -1;
+}
@@ -0,0 +1,47 @@
+// Registermodell av en BME680/BME688 på I2C
+#ifndef SIM_BME68X_H
+#define SIM_BME68X_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SIM_TRACE_MAX_FIELDS 8192
+
+// Inspelade rådata i compensation_bench-formatet ("calib"/"variant"/"field"-rader)
+typedef struct {
+    uint8_t calib[42];
+    uint8_t variant;
+    uint8_t (*fields)[17];
+    size_t n_fields;
+} sim_trace_t;
+
+typedef struct {
+    uint8_t regs[256];
+    uint8_t variant;
+    uint8_t mode;               // Läget sensorn faktiskt är i (ctrl_meas kan ha ändrats av en skrivning)
+    uint64_t done_us;           // När pågående mätning/cykel blir klar
+    uint8_t step;               // Aktuellt värmarsteg (gas_index)
+    uint8_t step_cycle;         // Parallellt läge: cykler gjorda i steget
+    uint8_t slot;               // Fältet (0..2) som nästa mätning skrivs till
+    uint8_t meas_index;
+    double timing_scale;        // Verklig mättid som andel av databladets värsta fall
+    const sim_trace_t *trace;   // Rådata att spela upp, NULL = syntetiska värden
+    uint32_t measurements;
+} sim_bme68x_t;
+
+// Ny sensor i sleep. calib är 42 bytes i ordningen 0x8A.., 0xE1.., 0x00..
+void sim_bme68x_init(sim_bme68x_t *dev, uint8_t variant, const uint8_t *calib);
+
+// Spela upp rådata: trace->fields används i tur och ordning för varje mätning
+void sim_bme68x_set_trace(sim_bme68x_t *dev, const sim_trace_t *trace);
+
+// Läs en tracefil. Returnerar 0 vid lyckad läsning.
+int sim_trace_load(sim_trace_t *trace, const char *path);
+
+// Registeråtkomst vid tiden now_us. Läsningar räknar upp registeradressen,
+// skrivningar är par av (register, värde) som på den riktiga sensorn.
+void sim_bme68x_read(sim_bme68x_t *dev, uint64_t now_us, uint8_t reg, uint8_t *dst, size_t len);
+void sim_bme68x_write(sim_bme68x_t *dev, uint64_t now_us, uint8_t reg, const uint8_t *src, size_t len);
+
+#endif
@@ -0,0 +1,158 @@
+// i2c_dma.h ovanpå de simulerade sensorerna. Varje transaktion räknas och får
+// en modellerad busstid: START, adressbyte, registerbyte, (repeated START och
+// adressbyte vid läsning,) data och STOP, 9 bittider per byte inklusive ACK.
+// Blockerande anrop låter klockan gå under överföringen, asynkrona anrop
+// lägger en händelse i kön som anropar cb när sista byten är klockad.
+#include "sim.h"
+#include "i2c_dma.h"
+#include <string.h>
+
+#define SIM_BUSES 2
+
+typedef struct {
+    uint baudrate;
+    volatile bool busy;
+    sim_bme68x_t *dev[128];
+    // Pågående asynkron överföring
+    bool write;
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t buf[I2C_DMA_MAX_LEN];
+    uint8_t *dst;
+    size_t len;
+    i2c_dma_cb_t cb;
+    void *user_data;
+} sim_bus_t;
+
+i2c_inst_t sim_i2c_inst[SIM_BUSES] = { { 0 }, { 1 } };
+
+static sim_bus_t buses[SIM_BUSES];
+
+static sim_bus_t *bus_get(i2c_inst_t *i2c) {
+    sim_bus_t *b = &buses[i2c_hw_index(i2c)];
+    return b->baudrate ? b : NULL;
+}
+
+void sim_bus_attach(uint bus, uint8_t addr, sim_bme68x_t *dev) {
+    if (bus < SIM_BUSES) buses[bus].dev[addr & 0x7f] = dev;
+}
+
+// Räkna transaktionen och returnera busstiden i hela mikrosekunder
+static uint64_t bus_account(const sim_bus_t *b, bool read, size_t len, bool acked) {
+    uint32_t bytes = acked ? (uint32_t)((read ? 3 : 2) + len) : 1;
+    uint32_t bits = bytes * 9 + (read && acked ? 3 : 2);
+    uint64_t ns = (uint64_t)bits * 1000000000u / b->baudrate;
+
+    if (read) {
+        sim_stats.reads++;
+    } else {
+        sim_stats.writes++;
+    }
+    if (!acked) sim_stats.nacks++;
+    sim_stats.bytes += bytes;
+    sim_stats.bus_ns += ns;
+    return (ns + 999) / 1000;
+}
+
+// Vänta ut en asynkron överföring, som bus_claim_blocking() i i2c_dma.c
+static void bus_wait(sim_bus_t *b) {
+    while (b->busy && sim_run_next(UINT64_MAX)) {
+    }
+}
+
+bool i2c_dma_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint baudrate) {
+    sim_bus_t *b = &buses[i2c_hw_index(i2c)];
+
+    b->baudrate = baudrate;
+    b->busy = false;
+    return true;
+}
+
+bool i2c_dma_busy(i2c_inst_t *i2c) {
+    sim_bus_t *b = bus_get(i2c);
+    return b && b->busy;
+}
+
+bool i2c_dma_read_reg(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len) {
+    sim_bus_t *b = bus_get(i2c);
+    if (!b || len == 0 || len > I2C_DMA_MAX_LEN) return false;
+
+    bus_wait(b);
+    sim_bme68x_t *dev = b->dev[addr & 0x7f];
+    uint64_t us = bus_account(b, true, len, dev != NULL);
+
+    b->busy = true;
+    if (dev) sim_bme68x_read(dev, sim_now_us(), reg, dst, len);
+    sim_run_until(sim_now_us() + us);
+    b->busy = false;
+    sim_stats.irqs++; // STOP_DET väcker __wfe() i i2c_dma.c
+    return dev != NULL;
+}
+
+bool i2c_dma_write_reg(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len) {
+    sim_bus_t *b = bus_get(i2c);
+    if (!b || len == 0 || len > I2C_DMA_MAX_LEN) return false;
+
+    bus_wait(b);
+    sim_bme68x_t *dev = b->dev[addr & 0x7f];
+    uint64_t us = bus_account(b, false, len, dev != NULL);
+
+    // Sensorn ser skrivningen vid STOP
+    b->busy = true;
+    sim_run_until(sim_now_us() + us);
+    b->busy = false;
+    sim_stats.irqs++;
+    if (dev) sim_bme68x_write(dev, sim_now_us(), reg, src, len);
+    return dev != NULL;
+}
+
+// Körs som DMA/I2C-avbrottet när överföringen är klar
+static void async_done(void *arg) {
+    sim_bus_t *b = arg;
+    sim_bme68x_t *dev = b->dev[b->addr & 0x7f];
+    i2c_dma_cb_t cb = b->cb;
+
+    if (dev && b->write) sim_bme68x_write(dev, sim_now_us(), b->reg, b->buf, b->len);
+    if (dev && !b->write) memcpy(b->dst, b->buf, b->len);
+    b->busy = false;
+    if (cb) cb(dev != NULL, b->user_data);
+}
+
+static bool async_start(sim_bus_t *b, bool write, uint8_t addr, uint8_t reg, size_t len,
+                        i2c_dma_cb_t cb, void *user_data) {
+    sim_bme68x_t *dev = b->dev[addr & 0x7f];
+    uint64_t us = bus_account(b, !write, len, dev != NULL);
+
+    b->busy = true;
+    b->write = write;
+    b->addr = addr;
+    b->reg = reg;
+    b->len = len;
+    b->cb = cb;
+    b->user_data = user_data;
+    // Statusbitarna samplas när läsningen börjar
+    if (dev && !write) sim_bme68x_read(dev, sim_now_us(), reg, b->buf, len);
+    if (!sim_schedule(sim_now_us() + us, async_done, b)) {
+        b->busy = false;
+        return false;
+    }
+    return true;
+}
+
+bool i2c_dma_read_reg_async(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *dst, size_t len,
+                            i2c_dma_cb_t cb, void *user_data) {
+    sim_bus_t *b = bus_get(i2c);
+    if (!b || b->busy || len == 0 || len > I2C_DMA_MAX_LEN) return false;
+
+    b->dst = dst;
+    return async_start(b, false, addr, reg, len, cb, user_data);
+}
+
+bool i2c_dma_write_reg_async(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *src, size_t len,
+                             i2c_dma_cb_t cb, void *user_data) {
+    sim_bus_t *b = bus_get(i2c);
+    if (!b || b->busy || len == 0 || len > I2C_DMA_MAX_LEN) return false;
+
+    memcpy(b->buf, src, len);
+    return async_start(b, true, addr, reg, len, cb, user_data);
+}
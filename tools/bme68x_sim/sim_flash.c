@@ -0,0 +1,35 @@
+// Simulerad flash för src/flash_store.c. Som riktig NOR-flash: radering sätter
+// hela sektorn till 0xFF och programmering kan bara nolla bitar.
+#include "sim.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include <string.h>
+
+uint8_t sim_flash[PICO_FLASH_SIZE_BYTES];
+
+void sim_flash_reset(void) {
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > sizeof(sim_flash)) {
+        fprintf(stderr, "flash_range_erase: ogiltigt område 0x%x+%zu\n", (unsigned)flash_offs, count);
+        return;
+    }
+    memset(&sim_flash[flash_offs], 0xFF, count);
+    sim_stats.flash_erases += (uint32_t)(count / FLASH_SECTOR_SIZE);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > sizeof(sim_flash)) {
+        fprintf(stderr, "flash_range_program: ogiltigt område 0x%x+%zu\n", (unsigned)flash_offs, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) sim_flash[flash_offs + i] &= data[i];
+    sim_stats.flash_pages += (uint32_t)(count / FLASH_PAGE_SIZE);
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    func(param);
+    return PICO_OK;
+}
@@ -0,0 +1,211 @@
+// Värdbenchmark för BME68x-kompenseringen. Jämför Bosch ursprungliga flyttalsväg
+// (stock) med drivrutinens flyttalsväg med förberäknade konstanter (float) och
+// heltalsvägen (int, BME680_FIXED_POINT). Mäter tid per mätvärde och största
+// avvikelse mot stock.
+//
+// Bygg och kör från repo-roten:
+//   gcc -O2 -Wall -Isrc -o compensation_bench tools/compensation_bench/*.c -lm
+//   ./compensation_bench              (syntetiskt svep över hela mätområdet)
+//   ./compensation_bench trace.txt    (inspelade rådata)
+//
+// Tracefil, en post per rad ('#' är kommentar):
+//   calib <42 bytes hex>    kalibreringsregistren 0x8A.., 0xE1.., 0x00.. i den ordningen
+//   variant <0|1>           0 = BME680 (gas low), 1 = BME688 (gas high)
+//   field <17 bytes hex>    rådata från FIELD0 (0x1D..0x2D)
+//
+// En trace kan spelas in från sensorn genom att bygga firmwaren med BME680_TRACE=1
+// och spara USB-seriens "calib"/"field"-rader.
+//
+// Obs: värden körs på värddatorn, som har FPU. På RP2040 (Cortex-M0+) går varje
+// flyttalsoperation via mjukvarurutiner, så skillnaden blir större där.
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#define MAX_SAMPLES 8192
+#define SWEEP_SAMPLES 4096
+#define PASSES 200
+
+// Typisk BME680-kalibrering, används när ingen trace anges
+static const uint8_t default_calib[42] = {
+    0xfb, 0x66, 0x03, 0x00, 0x5e, 0x8e, 0x55, 0xd7, 0x58, 0x00, 0xda, 0x1a,
+    0x89, 0xff, 0x29, 0x1e, 0x00, 0x00, 0xfc, 0xfe, 0xd1, 0xf3, 0x1e, 0x3e,
+    0x8c, 0x30, 0x00, 0x2d, 0x14, 0x78, 0x9c, 0x1c, 0x66, 0x42, 0xd9, 0xe2,
+    0x12, 0x2c, 0x00, 0x10, 0x00, 0xf0,
+};
+
+static uint8_t calib[42];
+static uint8_t variant_id;
+static uint8_t fields[MAX_SAMPLES][17];
+static size_t n_fields;
+
+static int parse_hex(const char *s, uint8_t *out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned int v;
+        while (*s == ' ') s++;
+        if (sscanf(s, "%2x", &v) != 1) return -1;
+        out[i] = (uint8_t)v;
+        s += 2;
+    }
+    return 0;
+}
+
+static int load_trace(const char *path) {
+    char line[256];
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    memcpy(calib, default_calib, sizeof(calib));
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (strncmp(line, "calib ", 6) == 0) {
+            if (parse_hex(line + 6, calib, sizeof(calib)) != 0) goto bad;
+        } else if (strncmp(line, "variant ", 8) == 0) {
+            variant_id = (uint8_t)atoi(line + 8);
+        } else if (strncmp(line, "field ", 6) == 0 && n_fields < MAX_SAMPLES) {
+            if (parse_hex(line + 6, fields[n_fields], 17) != 0) goto bad;
+            n_fields++;
+        } else {
+            goto bad;
+        }
+    }
+    fclose(f);
+    return 0;
+
+bad:
+    fprintf(stderr, "%s: ogiltig rad: %s", path, line);
+    fclose(f);
+    return -1;
+}
+
+// Deterministiskt svep över ADC-områdena (ca -20..65 °C, 300..1100 hPa, hela fukt- och gasområdet)
+static void make_sweep(void) {
+    uint32_t seed = 12345;
+
+    memcpy(calib, default_calib, sizeof(calib));
+    for (n_fields = 0; n_fields < SWEEP_SAMPLES; n_fields++) {
+        uint8_t *b = fields[n_fields];
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t temp_adc = 355000 + (seed >> 8) % 270000;
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t pres_adc = 250000 + (seed >> 8) % 330000;
+        seed = seed * 1664525u + 1013904223u;
+        uint16_t hum_adc = (uint16_t)(12000 + (seed >> 8) % 30000);
+        seed = seed * 1664525u + 1013904223u;
+        uint16_t gas_adc = (uint16_t)((seed >> 8) % 1024);
+        uint8_t gas_range = (uint8_t)((seed >> 4) & 0x0f);
+
+        memset(b, 0, 17);
+        b[0] = 0x80; // new_data
+        b[2] = (uint8_t)(pres_adc >> 12); b[3] = (uint8_t)(pres_adc >> 4); b[4] = (uint8_t)(pres_adc << 4);
+        b[5] = (uint8_t)(temp_adc >> 12); b[6] = (uint8_t)(temp_adc >> 4); b[7] = (uint8_t)(temp_adc << 4);
+        b[8] = (uint8_t)(hum_adc >> 8); b[9] = (uint8_t)hum_adc;
+        // Samma gasvärde i low- och high-registren, gas_valid + heat_stab satta
+        b[13] = b[15] = (uint8_t)(gas_adc >> 2);
+        b[14] = b[16] = (uint8_t)((gas_adc << 6) | 0x30 | gas_range);
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile double sink;
+
+static void time_kernel(const bench_kernel_t *k) {
+    bench_sample_t s;
+    double sum = 0;
+
+    k->setup(calib, variant_id);
+#ifdef HAVE_RDTSC
+    uint64_t c0 = __rdtsc();
+#endif
+    double t0 = now_ns();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (size_t i = 0; i < n_fields; i++) {
+            k->run(fields[i], &s);
+            sum += s.temperature + s.pressure;
+        }
+    }
+    double t1 = now_ns();
+    sink = sum;
+
+    double n = (double)PASSES * n_fields;
+#ifdef HAVE_RDTSC
+    printf("%-6s %8.1f ns/mätvärde %8.1f cykler/mätvärde\n", k->name, (t1 - t0) / n, (__rdtsc() - c0) / n);
+#else
+    printf("%-6s %8.1f ns/mätvärde\n", k->name, (t1 - t0) / n);
+#endif
+}
+
+typedef struct {
+    double max_abs;
+    double sum_abs;
+} err_t;
+
+static void err_add(err_t *e, double d) {
+    d = fabs(d);
+    if (d > e->max_abs) e->max_abs = d;
+    e->sum_abs += d;
+}
+
+static void compare(const bench_kernel_t *ref, const bench_kernel_t *k) {
+    err_t t = {0}, h = {0}, p = {0}, g = {0};
+    size_t n = 0;
+
+    ref->setup(calib, variant_id);
+    k->setup(calib, variant_id);
+    for (size_t i = 0; i < n_fields; i++) {
+        bench_sample_t f, q;
+
+        if (ref->run(fields[i], &f) != 0) continue;
+        if (k->run(fields[i], &q) != 0) continue;
+
+        // Jämför bara inom sensorns specificerade område
+        if (f.temperature < -40 || f.temperature > 85 || f.pressure < 30000 || f.pressure > 110000) continue;
+
+        err_add(&t, q.temperature - f.temperature);
+        err_add(&h, q.humidity - f.humidity);
+        err_add(&p, q.pressure - f.pressure);
+        if (f.gas > 0) err_add(&g, 100.0 * (q.gas - f.gas) / f.gas);
+        n++;
+    }
+
+    if (n == 0) {
+        printf("Inga jämförbara mätvärden\n");
+        return;
+    }
+    printf("\nAvvikelse %s mot %s (%zu mätvärden):\n", k->name, ref->name, n);
+    printf("  temperatur  max %.4f °C   medel %.4f °C\n", t.max_abs, t.sum_abs / n);
+    printf("  fukt        max %.4f %%RH  medel %.4f %%RH\n", h.max_abs, h.sum_abs / n);
+    printf("  tryck       max %.2f Pa    medel %.2f Pa\n", p.max_abs, p.sum_abs / n);
+    printf("  gas         max %.5f %%   medel %.5f %%\n", g.max_abs, g.sum_abs / n);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        if (load_trace(argv[1]) != 0) return 1;
+    } else {
+        make_sweep();
+    }
+    printf("%zu mätvärden, variant %u, %d varv\n\n", n_fields, variant_id, PASSES);
+
+    time_kernel(&kernel_stock);
+    time_kernel(&kernel_float);
+    time_kernel(&kernel_int);
+    compare(&kernel_stock, &kernel_float);
+    compare(&kernel_stock, &kernel_int);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef COMPENSATION_BENCH_H
+#define COMPENSATION_BENCH_H
+
+#include <stdint.h>
+
+// Ett kompenserat mätvärde i SI-enheter, oavsett vilken väg som räknade fram det
+typedef struct {
+    double temperature; // °C
+    double humidity;    // %
+    double pressure;    // Pa
+    double gas;         // ohm
+} bench_sample_t;
+
+// Kompenseringsväg: flyttal (BME68X_USE_FPU) eller heltal (BME68X_DO_NOT_USE_FPU)
+typedef struct {
+    const char *name;
+    // calib = de 42 kalibreringsbytes i samma ordning som bme68x_get_calib_raw() läser dem
+    int (*setup)(const uint8_t *calib, uint8_t variant_id);
+    // field = 17 rå bytes från FIELD0, som bme68x_parse_field_data() tar emot
+    int (*run)(const uint8_t *field, bench_sample_t *out);
+} bench_kernel_t;
+
+extern const bench_kernel_t kernel_stock;   // Bosch v4.4.8 flyttal, referens
+extern const bench_kernel_t kernel_float;
+extern const bench_kernel_t kernel_int;
+
+#endif
@@ -0,0 +1,42 @@
+// Flyttalsvägen (standard i bme68x_defs.h): drivrutinens version med förberäknade
+// kalibreringskonstanter, och Bosch ursprungliga funktioner som referens
+#include "bench.h"
+#include "bme68x.c"
+#include "kernel_common.h"
+#include "stock_kernels.h"
+
+static int float_run(const uint8_t *field, bench_sample_t *out) {
+    struct bme68x_data data;
+
+    if (bme68x_parse_field_data(field, &data, &dev) != BME68X_OK) return -1;
+    out->temperature = data.temperature;
+    out->humidity = data.humidity;
+    out->pressure = data.pressure;
+    out->gas = data.gas_resistance;
+    return 0;
+}
+
+const bench_kernel_t kernel_float = { "float", kernel_setup, float_run };
+
+// Som calc_field_data() men med Bosch oförändrade funktioner
+static int stock_run(const uint8_t *field, bench_sample_t *out) {
+    uint32_t adc_pres = ((uint32_t)field[2] * 4096) | ((uint32_t)field[3] * 16) | ((uint32_t)field[4] / 16);
+    uint32_t adc_temp = ((uint32_t)field[5] * 4096) | ((uint32_t)field[6] * 16) | ((uint32_t)field[7] / 16);
+    uint16_t adc_hum = (uint16_t)(((uint32_t)field[8] * 256) | (uint32_t)field[9]);
+    uint16_t adc_gas_low = (uint16_t)((uint32_t)field[13] * 4 | ((uint32_t)field[14] / 64));
+    uint16_t adc_gas_high = (uint16_t)((uint32_t)field[15] * 4 | ((uint32_t)field[16] / 64));
+
+    if (!(field[0] & BME68X_NEW_DATA_MSK)) return -1;
+
+    out->temperature = stock_calc_temperature(adc_temp, &dev);
+    out->pressure = stock_calc_pressure(adc_pres, &dev);
+    out->humidity = stock_calc_humidity(adc_hum, &dev);
+    if (dev.variant_id == BME68X_VARIANT_GAS_HIGH) {
+        out->gas = stock_calc_gas_resistance_high(adc_gas_high, field[16] & BME68X_GAS_RANGE_MSK);
+    } else {
+        out->gas = stock_calc_gas_resistance_low(adc_gas_low, field[14] & BME68X_GAS_RANGE_MSK, &dev);
+    }
+    return 0;
+}
+
+const bench_kernel_t kernel_stock = { "stock", kernel_setup, stock_run };
@@ -0,0 +1,39 @@
+// Heltalsvägen som firmwaren byggs med (BME680_FIXED_POINT=ON).
+// bme68x.c länkas även in av kernel_float.c, så de publika symbolerna döps om här.
+#define BME68X_DO_NOT_USE_FPU
+
+#define bme68x_init              int_bme68x_init
+#define bme68x_probe             int_bme68x_probe
+#define bme68x_get_calib_raw     int_bme68x_get_calib_raw
+#define bme68x_set_calib_raw     int_bme68x_set_calib_raw
+#define bme68x_set_regs          int_bme68x_set_regs
+#define bme68x_get_regs          int_bme68x_get_regs
+#define bme68x_soft_reset        int_bme68x_soft_reset
+#define bme68x_set_conf          int_bme68x_set_conf
+#define bme68x_get_conf          int_bme68x_get_conf
+#define bme68x_set_op_mode       int_bme68x_set_op_mode
+#define bme68x_get_op_mode       int_bme68x_get_op_mode
+#define bme68x_get_meas_dur      int_bme68x_get_meas_dur
+#define bme68x_get_data          int_bme68x_get_data
+#define bme68x_parse_field_data  int_bme68x_parse_field_data
+#define bme68x_parse_all_field_data int_bme68x_parse_all_field_data
+#define bme68x_set_heatr_conf    int_bme68x_set_heatr_conf
+#define bme68x_get_heatr_conf    int_bme68x_get_heatr_conf
+#define bme68x_selftest_check    int_bme68x_selftest_check
+
+#include "bench.h"
+#include "bme68x.c"
+#include "kernel_common.h"
+
+static int int_run(const uint8_t *field, bench_sample_t *out) {
+    struct bme68x_data data;
+
+    if (bme68x_parse_field_data(field, &data, &dev) != BME68X_OK) return -1;
+    out->temperature = data.temperature / 100.0;
+    out->humidity = data.humidity / 1000.0;
+    out->pressure = data.pressure;
+    out->gas = data.gas_resistance;
+    return 0;
+}
+
+const bench_kernel_t kernel_int = { "int", kernel_setup, int_run };
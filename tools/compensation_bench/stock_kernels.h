@@ -0,0 +1,132 @@
+// Oförändrade flyttalsfunktioner från Bosch BME68x Sensor API v4.4.8, innan
+// kalibreringen började förberäkna härledda konstanter. Används som referens
+// av kernel_float.c och får inte ändras.
+/* @brief This internal API is used to calculate the temperature value. */
+static float stock_calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+{
+    float var1;
+    float var2;
+    float calc_temp;
+
+    /* calculate var1 data */
+    var1 = ((((float)temp_adc / 16384.0f) - ((float)dev->calib.par_t1 / 1024.0f)) * ((float)dev->calib.par_t2));
+
+    /* calculate var2 data */
+    var2 =
+        (((((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f)) *
+          (((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f))) * ((float)dev->calib.par_t3 * 16.0f));
+
+    /* t_fine value*/
+    dev->calib.t_fine = (var1 + var2);
+
+    /* compensated temperature data*/
+    calc_temp = ((dev->calib.t_fine) / 5120.0f);
+
+    return calc_temp;
+}
+
+/* @brief This internal API is used to calculate the pressure value. */
+static float stock_calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+{
+    float var1;
+    float var2;
+    float var3;
+    float calc_pres;
+
+    var1 = (((float)dev->calib.t_fine / 2.0f) - 64000.0f);
+    var2 = var1 * var1 * (((float)dev->calib.par_p6) / (131072.0f));
+    var2 = var2 + (var1 * ((float)dev->calib.par_p5) * 2.0f);
+    var2 = (var2 / 4.0f) + (((float)dev->calib.par_p4) * 65536.0f);
+    var1 = (((((float)dev->calib.par_p3 * var1 * var1) / 16384.0f) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
+    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)dev->calib.par_p1));
+    calc_pres = (1048576.0f - ((float)pres_adc));
+
+    /* Avoid exception caused by division by zero */
+    if ((int)var1 != 0)
+    {
+        calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
+        var1 = (((float)dev->calib.par_p9) * calc_pres * calc_pres) / 2147483648.0f;
+        var2 = calc_pres * (((float)dev->calib.par_p8) / 32768.0f);
+        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (dev->calib.par_p10 / 131072.0f));
+        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)dev->calib.par_p7 * 128.0f)) / 16.0f);
+    }
+    else
+    {
+        calc_pres = 0;
+    }
+
+    return calc_pres;
+}
+
+/* This internal API is used to calculate the humidity in integer */
+static float stock_calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+{
+    float calc_hum;
+    float var1;
+    float var2;
+    float var3;
+    float var4;
+    float temp_comp;
+
+    /* compensated temperature data*/
+    temp_comp = ((dev->calib.t_fine) / 5120.0f);
+    var1 = (float)((float)hum_adc) -
+           (((float)dev->calib.par_h1 * 16.0f) + (((float)dev->calib.par_h3 / 2.0f) * temp_comp));
+    var2 = var1 *
+           ((float)(((float)dev->calib.par_h2 / 262144.0f) *
+                    (1.0f + (((float)dev->calib.par_h4 / 16384.0f) * temp_comp) +
+                     (((float)dev->calib.par_h5 / 1048576.0f) * temp_comp * temp_comp))));
+    var3 = (float)dev->calib.par_h6 / 16384.0f;
+    var4 = (float)dev->calib.par_h7 / 2097152.0f;
+    calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
+    if (calc_hum > 100.0f)
+    {
+        calc_hum = 100.0f;
+    }
+    else if (calc_hum < 0.0f)
+    {
+        calc_hum = 0.0f;
+    }
+
+    return calc_hum;
+}
+
+/* This internal API is used to calculate the gas resistance low value in float */
+static float stock_calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
+{
+    float calc_gas_res;
+    float var1;
+    float var2;
+    float var3;
+    float gas_res_f = gas_res_adc;
+    float gas_range_f = (1U << gas_range); /*lint !e790 / Suspicious truncation, integral to float */
+    const float lookup_k1_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
+    };
+    const float lookup_k2_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+    };
+
+    var1 = (1340.0f + (5.0f * dev->calib.range_sw_err));
+    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
+    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
+    calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
+
+    return calc_gas_res;
+}
+
+/* This internal API is used to calculate the gas resistance value in float */
+static float stock_calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
+{
+    float calc_gas_res;
+    uint32_t var1 = UINT32_C(262144) >> gas_range;
+    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+
+    var2 *= INT32_C(3);
+    var2 = INT32_C(4096) + var2;
+
+    calc_gas_res = 1000000.0f * (float)var1 / (float)var2;
+
+    return calc_gas_res;
+}
+
@@ -0,0 +1,81 @@
+// Genererar src/bme68x_tables.h: gasområdestabellerna som bme68x.c annars
+// räknade fram vid varje mätning. Tabellerna beror bara på gas_range, inte på
+// sensorns kalibrering, så de tas fram en gång och checkas in. CMake kör inte
+// generatorn, så kör den igen och checka in resultatet när tabellerna ändras:
+//
+//   gcc -O2 -Wall -o gen_bme68x_tables tools/gen_bme68x_tables/gen_bme68x_tables.c
+//   ./gen_bme68x_tables > src/bme68x_tables.h
+//
+// Flyttalen räknas i float i samma ordning som drivrutinen gjorde tidigare och
+// skrivs med 9 siffror, så att de läses tillbaka bit för bit identiskt.
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Områdeskorrektioner i procent från Bosch BME68x Sensor API (BME680, gas low)
+static const float k1_range[16] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
+};
+static const float k2_range[16] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+};
+
+static void print_float_table(const char *doc, const char *name, const float *v) {
+    printf("/* %s */\n", doc);
+    printf("static const float %s[16] = {\n", name);
+    for (int i = 0; i < 16; i++) {
+        char num[32];
+        snprintf(num, sizeof(num), "%.9g", v[i]);
+        if (!strpbrk(num, ".e")) strcat(num, ".0"); // "1" -> "1.0", annars blir "1f" ogiltigt
+        printf("%s%sf,%s", (i % 4) ? " " : "    ", num, (i % 4 == 3) ? "\n" : "");
+    }
+    printf("};\n\n");
+}
+
+static void print_u32_table(const char *doc, const char *name, const uint32_t *v) {
+    printf("/* %s */\n", doc);
+    printf("static const uint32_t %s[16] = {\n", name);
+    for (int i = 0; i < 16; i++) {
+        printf("%sUINT32_C(%lu),%s", (i % 4) ? " " : "    ", (unsigned long)v[i], (i % 4 == 3) ? "\n" : "");
+    }
+    printf("};\n\n");
+}
+
+int main(void) {
+    float f_scale[16], f_k1_inv[16], f_high[16];
+    uint32_t u_low1[16], u_low2[16], u_high[16];
+
+    for (int r = 0; r < 16; r++) {
+        f_scale[r] = (1.0f + (k2_range[r] / 100.0f)) * 0.000000125f * (float)(1U << r);
+        f_k1_inv[r] = 1.0f / (1.0f + (k1_range[r] / 100.0f));
+        f_high[r] = 1000000.0f * (float)(UINT32_C(262144) >> r);
+
+        // Heltalsvägens tabeller i Bosch fixpunktsformat
+        u_low1[r] = (uint32_t)(2147483647.0 * (1.0 + k1_range[r] / 100.0));
+        if (u_low1[r] > 2147483647u) u_low1[r] = 2147483647u;
+        u_low2[r] = (uint32_t)((4096000000.0 / (double)(1U << r)) / (1.0 + k2_range[r] / 100.0));
+        u_high[r] = UINT32_C(10000) * (UINT32_C(262144) >> r);
+    }
+
+    printf("/*\n"
+           " * Generated by tools/gen_bme68x_tables, do not edit.\n"
+           " * The file is pre-generated and checked in; the build does not run the\n"
+           " * generator. Regenerate it after changing the tables with:\n"
+           " *\n"
+           " *   gcc -O2 -Wall -o gen_bme68x_tables tools/gen_bme68x_tables/gen_bme68x_tables.c\n"
+           " *   ./gen_bme68x_tables > src/bme68x_tables.h\n"
+           " */\n\n");
+    printf("#ifndef BME68X_TABLES_H_\n#define BME68X_TABLES_H_\n\n");
+    printf("#include <stdint.h>\n\n");
+    printf("#ifdef BME68X_USE_FPU\n\n");
+    print_float_table("(1 + k2[range] / 100) * 0.000000125 * 2^range, gas low variant",
+                      "bme68x_gas_low_scale", f_scale);
+    print_float_table("1 / (1 + k1[range] / 100), gas low variant", "bme68x_gas_low_k1_inv", f_k1_inv);
+    print_float_table("1000000 * (262144 >> range), gas high variant", "bme68x_gas_high_num", f_high);
+    printf("#else\n\n");
+    print_u32_table("2^31 * (1 + k1[range] / 100), gas low variant", "bme68x_gas_low_table1", u_low1);
+    print_u32_table("4096000000 / 2^range / (1 + k2[range] / 100), gas low variant", "bme68x_gas_low_table2", u_low2);
+    print_u32_table("10000 * (262144 >> range), gas high variant", "bme68x_gas_high_num", u_high);
+    printf("#endif\n\n#endif /* BME68X_TABLES_H_ */\n");
+    return 0;
+}
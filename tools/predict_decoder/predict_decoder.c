@@ -0,0 +1,62 @@
+#include "predict_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void pd_init(pd_decoder_t *d, uint8_t channels, uint32_t linear) {
+    memset(d, 0, sizeof(*d));
+    predict_init(&d->state, channels, linear);
+}
+
+bool pd_receive(pd_decoder_t *d, uint32_t mseq, uint32_t seq, bool keyframe, uint32_t mask, const int32_t *values) {
+    if (d->started && mseq != d->state.mseq) {
+        d->lost += mseq - d->state.mseq;
+        d->synced = false;
+    }
+    if (keyframe) d->synced = true;
+
+    // Modellen följer sändarens numrering även efter en lucka
+    d->state.mseq = mseq;
+    predict_apply(&d->state, seq, values, mask, keyframe);
+    d->seq = seq;
+    d->started = true;
+    d->received++;
+    return d->synced;
+}
+
+// Heltalet efter "key": i json, false om nyckeln saknas
+static bool find_int(const char *json, const char *key, long *out) {
+    char pattern[40];
+    const char *p;
+    char *end;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    p = strstr(json, pattern);
+    if (!p) return false;
+    *out = strtol(p + strlen(pattern), &end, 10);
+    return end != p + strlen(pattern);
+}
+
+bool pd_receive_json(pd_decoder_t *d, const char *json, const char *const *names) {
+    int32_t values[PREDICT_MAX_CHANNELS] = { 0 };
+    uint32_t mask = 0;
+    long mseq, seq, key, v;
+
+    if (!find_int(json, "mseq", &mseq) || !find_int(json, "seq", &seq) || !find_int(json, "key", &key)) return false;
+    for (uint8_t i = 0; i < d->state.count; i++) {
+        if (find_int(json, names[i], &v)) {
+            values[i] = (int32_t)v;
+            mask |= 1u << i;
+        }
+    }
+    // En keyframe måste ha alla kanaler
+    if (key && mask != (1u << d->state.count) - 1) return false;
+
+    pd_receive(d, (uint32_t)mseq, (uint32_t)seq, key != 0, mask, values);
+    return true;
+}
+
+int32_t pd_value(const pd_decoder_t *d, uint8_t ch, uint32_t seq) {
+    if (ch >= d->state.count) return 0;
+    return predict_value(&d->state.ch[ch], seq);
+}
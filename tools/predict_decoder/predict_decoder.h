@@ -0,0 +1,37 @@
+// Mottagarsidan av den prediktiva kodningen (src/predict.h) för Linux.
+// Kör samma modell som firmwaren och räknar fram varje kanals värde för alla
+// mätningar mellan meddelandena. Ett tappat meddelande (lucka i mseq) gör
+// avkodaren osynkad tills nästa keyframe.
+//
+// Bygg som delat bibliotek från repo-roten:
+//   gcc -O2 -Wall -fPIC -shared -Isrc -Itools/predict_decoder -o libpredict_decoder.so
+//       tools/predict_decoder/predict_decoder.c src/predict.c src/deadband.c
+#ifndef PREDICT_DECODER_H
+#define PREDICT_DECODER_H
+
+#include "predict.h"
+
+typedef struct {
+    predict_state_t state;
+    bool synced;            // Samma modell som sändaren, sedan senaste keyframe
+    bool started;           // Minst ett meddelande mottaget
+    uint32_t seq;           // Senaste meddelandets mätning
+    uint32_t received;
+    uint32_t lost;          // Meddelanden som saknades enligt mseq
+} pd_decoder_t;
+
+// channels och linear som sändaren (CH_COUNT och PREDICT_LINEAR i main.c)
+void pd_init(pd_decoder_t *d, uint8_t channels, uint32_t linear);
+
+// Ta emot ett meddelande. values har ett värde per kanal, bara kanalerna i mask
+// (alla vid keyframe) används. Returnerar avkodarens synkstatus efteråt.
+bool pd_receive(pd_decoder_t *d, uint32_t mseq, uint32_t seq, bool keyframe, uint32_t mask, const int32_t *values);
+
+// Ta emot ett meddelande i firmwarens JSON-format (ett element i "pc"), med
+// kanalnamnen i samma ordning som på sändaren. Returnerar false om det inte gick att tolka.
+bool pd_receive_json(pd_decoder_t *d, const char *json, const char *const *names);
+
+// Kanalens värde vid mätning seq (samma eller senare än senaste meddelandet)
+int32_t pd_value(const pd_decoder_t *d, uint8_t ch, uint32_t seq);
+
+#endif
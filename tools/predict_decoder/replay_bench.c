@@ -0,0 +1,344 @@
+// Replaybenchmark för den prediktiva kodningen (src/predict.c). Spelar upp en
+// inspelad eller syntetisk mätserie genom firmwarens tre sätt att publicera
+// rådata: varje mätning, deadband med heartbeat (PUBLISH_DEADBAND) och prediktiv
+// kodning (PUBLISH_PREDICT). Räknar meddelanden och bytes. Meddelandena körs
+// som JSON genom avkodaren (predict_decoder.c), och dess rekonstruktion jämförs
+// med de verkliga värdena. Kontrollerar också att avkodaren är i lås med sändaren
+// och hur snabbt en keyframe synkar om efter tappade meddelanden.
+//
+// Bygg och kör från repo-roten:
+//   gcc -O2 -Wall -DBME68X_DO_NOT_USE_FPU -Isrc -Itools/predict_decoder -Itools/bme68x_sim/shim -o predict_replay
+//       tools/predict_decoder/*.c src/predict.c src/deadband.c src/iaq.c src/bme68x.c -lm
+//   ./predict_replay              (syntetiskt dygn, en mätning var 5:e sekund)
+//   ./predict_replay trace.txt    (inspelade rådata, se tools/compensation_bench)
+//
+// En trace har ingen tidsstämpel; varje field-rad räknas som en mätning var 5:e sekund.
+// IAQ räknas som i firmwaren med iaq.c från gasen och luftfuktigheten (pico-
+// headrarna som iaq.h drar in kommer från simulatorns shim).
+#include "predict_decoder.h"
+#include "bme68x.h"
+#include "iaq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SAMPLE_S 5
+#define MAX_SAMPLES (2 * 24 * 3600 / SAMPLE_S)
+#define HEARTBEAT_SAMPLES (15 * 60 / SAMPLE_S)     // DEADBAND_HEARTBEAT_MS
+#define KEYFRAME_SAMPLES (60 * 60 / SAMPLE_S)      // PREDICT_KEYFRAME_SAMPLES
+#define LOSS_PERMILLE 50
+
+enum { CH_TEMPERATURE, CH_HUMIDITY, CH_PRESSURE, CH_GAS, CH_IAQ, CH_COUNT };
+static const char *const names[CH_COUNT] = { "temperature", "humidity", "pressure", "gas", "iaq" };
+
+// Samma band som channel_bands i main.c
+static const deadband_band_t bands[CH_COUNT] = {
+    { 10, 0 },      // 0.10 °C
+    { 1000, 0 },    // 1 %RH
+    { 50, 0 },      // 0.5 hPa
+    { 0, 50 },      // 5 % av gasresistansen
+    { 10, 0 },      // 10 IAQ-enheter
+};
+
+// Samma som PREDICT_LINEAR i main.c: gas och IAQ ändras i steg och hålls
+#define LINEAR ((1u << CH_TEMPERATURE) | (1u << CH_HUMIDITY) | (1u << CH_PRESSURE))
+
+// Samma typiska BME680-kalibrering som compensation_bench
+static const uint8_t default_calib[42] = {
+    0xfb, 0x66, 0x03, 0x00, 0x5e, 0x8e, 0x55, 0xd7, 0x58, 0x00, 0xda, 0x1a,
+    0x89, 0xff, 0x29, 0x1e, 0x00, 0x00, 0xfc, 0xfe, 0xd1, 0xf3, 0x1e, 0x3e,
+    0x8c, 0x30, 0x00, 0x2d, 0x14, 0x78, 0x9c, 0x1c, 0x66, 0x42, 0xd9, 0xe2,
+    0x12, 0x2c, 0x00, 0x10, 0x00, 0xf0,
+};
+
+static int32_t samples[MAX_SAMPLES][CH_COUNT];
+static size_t n_samples;
+static iaq_t iaq;
+
+// IAQ uppdateras vid varje gasmätning och hålls däremellan, som sensor_iaq i main.c
+static int32_t iaq_sample(uint32_t gas, uint32_t humidity) {
+    bme680_reading_t reading = { .gas = gas, .humidity = humidity, .has_gas = true };
+    return iaq_update(&iaq, &reading);
+}
+
+static int parse_hex(const char *s, uint8_t *out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned int v;
+        while (*s == ' ') s++;
+        if (sscanf(s, "%2x", &v) != 1) return -1;
+        out[i] = (uint8_t)v;
+        s += 2;
+    }
+    return 0;
+}
+
+// Ingen buss, kalibreringen laddas med bme68x_set_calib_raw() som i compensation_bench
+static int8_t no_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void *intf_ptr) {
+    (void)reg_addr; (void)data; (void)len; (void)intf_ptr;
+    return -1;
+}
+
+static int8_t no_write(uint8_t reg_addr, const uint8_t *data, uint32_t len, void *intf_ptr) {
+    (void)reg_addr; (void)data; (void)len; (void)intf_ptr;
+    return -1;
+}
+
+static void no_delay(uint32_t period, void *intf_ptr) {
+    (void)period; (void)intf_ptr;
+}
+
+// Kompensera tracens rådata med drivrutinens heltalsväg. Gas och IAQ hålls
+// mellan gasmätningarna, som sensor_gas och sensor_iaq i main.c.
+static int load_trace(const char *path) {
+    struct bme68x_dev dev;
+    uint8_t calib[42];
+    char line[256];
+    int32_t gas = 0, index = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    memset(&dev, 0, sizeof(dev));
+    dev.intf = BME68X_I2C_INTF;
+    dev.read = no_read;
+    dev.write = no_write;
+    dev.delay_us = no_delay;
+    dev.amb_temp = 25;
+    dev.skip_heatr_meta = BME68X_ENABLE;
+    memcpy(calib, default_calib, sizeof(calib));
+    bme68x_set_calib_raw(calib, &dev);
+
+    while (fgets(line, sizeof(line), f) && n_samples < MAX_SAMPLES) {
+        uint8_t field[BME68X_LEN_FIELD];
+        struct bme68x_data data;
+
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (strncmp(line, "calib ", 6) == 0) {
+            if (parse_hex(line + 6, calib, sizeof(calib)) != 0) goto bad;
+            bme68x_set_calib_raw(calib, &dev);
+        } else if (strncmp(line, "variant ", 8) == 0) {
+            dev.variant_id = (uint8_t)atoi(line + 8);
+        } else if (strncmp(line, "field ", 6) == 0) {
+            if (parse_hex(line + 6, field, sizeof(field)) != 0) goto bad;
+            if (bme68x_parse_field_data(field, &data, &dev) != BME68X_OK) continue;
+            if (data.status & BME68X_GASM_VALID_MSK) {
+                gas = (int32_t)data.gas_resistance;
+                index = iaq_sample(data.gas_resistance, data.humidity);
+            }
+            samples[n_samples][CH_TEMPERATURE] = data.temperature;
+            samples[n_samples][CH_HUMIDITY] = (int32_t)data.humidity;
+            samples[n_samples][CH_PRESSURE] = (int32_t)data.pressure;
+            samples[n_samples][CH_GAS] = gas;
+            samples[n_samples][CH_IAQ] = index;
+            n_samples++;
+        } else {
+            goto bad;
+        }
+    }
+    fclose(f);
+    return 0;
+
+bad:
+    fprintf(stderr, "%s: ogiltig rad: %s", path, line);
+    fclose(f);
+    return -1;
+}
+
+static uint32_t seed = 12345;
+
+// Ungefär normalfördelat brus med standardavvikelsen sd
+static double noise(double sd) {
+    double sum = 0;
+    for (int i = 0; i < 4; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        sum += (seed >> 8) / 16777216.0 - 0.5;
+    }
+    return sum * sd * 1.732;
+}
+
+// Ett kontorsdygn: temperatur och luftfuktighet följer dygnet och ventilationen
+// (termostatcykler på 20 minuter), trycket en väderfront och gasen närvaro med VOC-toppar.
+// Gas mäts var sjätte mätning (GAS_INTERVAL_MS) och hålls däremellan, liksom IAQ.
+static void make_day(void) {
+    const double day = 24 * 3600;
+    int32_t gas = 0, index = 0;
+
+    for (n_samples = 0; n_samples < (size_t)(day / SAMPLE_S); n_samples++) {
+        double t = (double)n_samples * SAMPLE_S;
+        double h = fmod(t / 3600.0, 24.0);
+        double diurnal = sin(2 * M_PI * (t / day - 0.375));
+        double hvac = fabs(fmod(t, 1200.0) / 600.0 - 1) - 0.5;   // Termostaten värmer och svalnar
+        bool occupied = h >= 8 && h < 17;
+
+        samples[n_samples][CH_TEMPERATURE] = (int32_t)lround(2150 + 120 * diurnal + 4 * hvac + (occupied ? 40 : 0) + noise(1.0));
+        samples[n_samples][CH_HUMIDITY] = (int32_t)lround(42000 - 4000 * diurnal + (occupied ? 2500 : 0) + noise(40));
+        samples[n_samples][CH_PRESSURE] = (int32_t)lround(101300 - 250 * tanh((t - 14 * 3600) / 7200) + noise(2.5));
+        if (n_samples % 6 == 0) {
+            double g = occupied ? 75000 - 10000 * sin(M_PI * (h - 8) / 9) : 120000;
+            if (occupied && fmod(t, 5400.0) < 600) g *= 0.8; // Möte / städning
+            gas = (int32_t)lround(g * (1 + noise(0.01)));
+            index = iaq_sample((uint32_t)gas, (uint32_t)samples[n_samples][CH_HUMIDITY]);
+        }
+        samples[n_samples][CH_GAS] = gas;
+        samples[n_samples][CH_IAQ] = index;
+    }
+}
+
+// Deadband som i raw_due() i main.c: meddelande när någon kanal är utanför bandet eller efter heartbeat
+static void run_deadband(uint32_t *messages, uint64_t *bytes) {
+    deadband_ref_t ref;
+    predict_state_t fmt;
+    char json[256];
+    size_t last = 0;
+
+    memset(&ref, 0, sizeof(ref));
+    predict_init(&fmt, CH_COUNT, LINEAR);
+    *messages = 0;
+    *bytes = 0;
+    for (size_t i = 0; i < n_samples; i++) {
+        bool due = *messages == 0 || i - last >= HEARTBEAT_SAMPLES;
+        for (int c = 0; c < CH_COUNT && !due; c++) due = deadband_exceeded(&ref, &bands[c], c, samples[i][c]);
+        if (!due) continue;
+
+        for (int c = 0; c < CH_COUNT; c++) deadband_set(&ref, c, samples[i][c]);
+        *bytes += predict_fmt_json(json, sizeof(json), "i2c0-76", &fmt, (uint32_t)i + 1, samples[i], 0, true, names);
+        (*messages)++;
+        last = i;
+    }
+}
+
+typedef struct {
+    uint32_t messages;
+    uint32_t keyframes;
+    uint32_t values;            // Skickade kanalvärden
+    uint64_t bytes;
+    uint32_t lost;
+    uint32_t unsynced;          // Mätningar från ett tappat meddelande till nästa mottagna keyframe
+    uint32_t lockstep_errors;   // Meddelanden där avkodarens modell skilde sig från sändarens
+    uint32_t out_of_band;       // Synkade mätningar där rekonstruktionen låg utanför bandet
+    int64_t max_err[CH_COUNT];  // Största fel, synkad
+    int64_t max_err_unsynced[CH_COUNT];
+} predict_result_t;
+
+// Prediktiv kodning som i main.c, med loss_permille tappade meddelanden mellan sändare och avkodare
+static void run_predict(uint32_t loss_permille, predict_result_t *r) {
+    predict_state_t enc;
+    pd_decoder_t dec;
+    char json[256];
+    bool missed = false;        // Mottagaren vet det först vid nästa meddelande
+
+    memset(r, 0, sizeof(*r));
+    predict_init(&enc, CH_COUNT, LINEAR);
+    pd_init(&dec, CH_COUNT, LINEAR);
+    seed = 777;
+
+    for (size_t i = 0; i < n_samples; i++) {
+        uint32_t seq = (uint32_t)i + 1; // reading.seq börjar på 1
+        bool key = predict_keyframe_due(&enc, seq, KEYFRAME_SAMPLES);
+        uint32_t mask = predict_check(&enc, seq, samples[i], bands);
+
+        if (key || mask) {
+            r->bytes += predict_fmt_json(json, sizeof(json), "i2c0-76", &enc, seq, samples[i], mask, key, names);
+            predict_apply(&enc, seq, samples[i], mask, key);
+            r->messages++;
+            r->keyframes += key;
+            for (int c = 0; c < CH_COUNT; c++) r->values += key || (mask & (1u << c));
+
+            seed = seed * 1664525u + 1013904223u;
+            if ((seed >> 8) % 1000 < loss_permille) {
+                r->lost++;
+                missed = true;
+            } else {
+                if (key) missed = false;
+                if (!pd_receive_json(&dec, json, names)) {
+                    fprintf(stderr, "kunde inte tolka: %s\n", json);
+                    exit(1);
+                }
+                if (!missed && memcmp(dec.state.ch, enc.ch, sizeof(enc.ch)) != 0) r->lockstep_errors++;
+            }
+        }
+
+        // Mottagarens bild av mätningen
+        if (!dec.started) continue;
+        if (missed) r->unsynced++;
+        for (int c = 0; c < CH_COUNT; c++) {
+            int32_t pred = pd_value(&dec, (uint8_t)c, seq);
+            int64_t err = llabs((int64_t)samples[i][c] - pred);
+            if (!missed) {
+                if (err > r->max_err[c]) r->max_err[c] = err;
+                if (err > deadband_limit(&bands[c], pred)) r->out_of_band++;
+            } else if (err > r->max_err_unsynced[c]) {
+                r->max_err_unsynced[c] = err;
+            }
+        }
+    }
+}
+
+// Ett fel i kanalens enhet: °C, %RH, hPa med två decimaler och ohm
+static const char *fmt_err(char *buf, size_t len, int c, int64_t v) {
+    switch (c) {
+        case CH_TEMPERATURE:
+        case CH_PRESSURE:
+            snprintf(buf, len, "%lld.%02lld", (long long)(v / 100), (long long)(v % 100));
+            break;
+        case CH_HUMIDITY:
+            snprintf(buf, len, "%lld.%03lld", (long long)(v / 1000), (long long)(v % 1000));
+            break;
+        default:
+            snprintf(buf, len, "%lld", (long long)v);
+    }
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    uint32_t db_messages;
+    uint64_t db_bytes;
+    predict_result_t pr, lossy;
+    char a[24], b[24];
+
+    iaq_init(&iaq);
+    if (argc > 1) {
+        if (load_trace(argv[1]) != 0) return 1;
+        printf("Trace %s: %zu mätningar\n", argv[1], n_samples);
+    } else {
+        make_day();
+        printf("Syntetiskt kontorsdygn: %zu mätningar\n", n_samples);
+    }
+    if (n_samples == 0) return 1;
+    printf("En mätning var %d s, heartbeat var %d:e, keyframe var %d:e mätning\n\n",
+           SAMPLE_S, HEARTBEAT_SAMPLES, KEYFRAME_SAMPLES);
+
+    run_deadband(&db_messages, &db_bytes);
+    run_predict(0, &pr);
+    run_predict(LOSS_PERMILLE, &lossy);
+
+    printf("%-22s %10s %10s %12s %10s\n", "", "meddelanden", "minskning", "bytes", "värden");
+    printf("%-22s %10zu %9.1fx %12llu %10zu\n", "varje mätning", n_samples, 1.0,
+           (unsigned long long)(db_bytes * n_samples / (db_messages ? db_messages : 1)), n_samples * CH_COUNT);
+    printf("%-22s %10u %9.1fx %12llu %10u\n", "deadband + heartbeat", db_messages,
+           (double)n_samples / db_messages, (unsigned long long)db_bytes, db_messages * CH_COUNT);
+    printf("%-22s %10u %9.1fx %12llu %10u\n", "prediktiv", pr.messages,
+           (double)n_samples / pr.messages, (unsigned long long)pr.bytes, pr.values);
+    printf("  varav %u keyframes\n\n", pr.keyframes);
+
+    printf("Rekonstruktion hos mottagaren (största fel)\n");
+    for (int c = 0; c < CH_COUNT; c++) {
+        printf("  %-12s %10s (band %s%s)\n", names[c], fmt_err(a, sizeof(a), c, pr.max_err[c]),
+               bands[c].abs ? fmt_err(b, sizeof(b), c, bands[c].abs) : "",
+               bands[c].rel_permille ? " 5 %" : "");
+    }
+    printf("  utanför bandet: %u mätningar, ur lås: %u meddelanden\n\n", pr.out_of_band, pr.lockstep_errors);
+
+    printf("Med %d promille tappade meddelanden: %u tappade, osynkad %u av %zu mätningar (%.1f %%)\n",
+           LOSS_PERMILLE, lossy.lost, lossy.unsynced, n_samples, 100.0 * lossy.unsynced / n_samples);
+    for (int c = 0; c < CH_COUNT; c++) {
+        printf("  %-12s synkad %10s, osynkad %10s\n", names[c], fmt_err(a, sizeof(a), c, lossy.max_err[c]),
+               fmt_err(b, sizeof(b), c, lossy.max_err_unsynced[c]));
+    }
+    printf("  utanför bandet när synkad: %u mätningar, ur lås: %u meddelanden\n", lossy.out_of_band, lossy.lockstep_errors);
+
+    return pr.out_of_band || pr.lockstep_errors || lossy.out_of_band || lossy.lockstep_errors ? 1 : 0;
+}